@@ -1,6 +1,19 @@
 #include "RIQAudio.hpp"
 #include "UnityHelpers.hpp"
 
+#include <float.h>
+#include <math.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+// NOTE: Define RIQ_NO_SIMD to force the scalar paths, output is then bit-exact across platforms
+#if !defined(RIQ_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+	#define RIQ_SIMD_SSE2
+	#include <emmintrin.h>
+#endif
+
 // Rust users cry
 #ifndef RIQ_MALLOC
 	#define RIQ_MALLOC(sz)          malloc(sz);
@@ -47,55 +60,151 @@
 static AudioData AUDIO = { };
 
 static void OnLog(void* pUserData, ma_uint32 level, const char* pMessage);
+static Sound LoadSoundFromWaveEx(Wave wave, float thresholdDb, bool trim);
 static void OnSendAudioDataToDevice(ma_device* pDevice, void* pFramesOut, const void* pFramesInput, ma_uint32 frameCount);
+static int GetChannelLayoutIndex(ma_uint32 channels);
+
+static void RebaseAudioBuffersSampleRate(void);
+static void StartAudioBuffersRebake(void);
+static void StopAudioBuffersRebake(void);
+
+static void ReclaimRetiredAudioMemory(bool force);
+static void UnlinkUnloadedAudioBuffers(void);
+static void ReleaseAudioBuffer(void* ptr);
+
+static void ProcessLatencyCalibration(float* framesOut, const float* framesIn, ma_uint32 frameCount, ma_uint32 channels);
+static void StopAudioSpectrum(void);
+
+static SilenceSpan* LoadSilenceSpans(const float* data, ma_uint32 channels, ma_uint32 frameCount, float threshold, unsigned int* spanCount);
+static ma_uint32 GetAudioBufferLeadDelay(const AudioBuffer* buffer);
+static void StartAudioBufferLeadDelay(AudioBuffer* buffer);
+
+static const char* GetFileExtension(const char* fileName);
+static unsigned char* LoadFileData(const char* fileName, unsigned int* bytesRead);
 
 void RiqInitAudioDevice(void)
+{
+	RiqInitAudioDeviceEx(RiqGetDefaultAudioDeviceOptions());
+}
+
+AudioDeviceOptions RiqGetDefaultAudioDeviceOptions(void)
+{
+	AudioDeviceOptions options = { 0 };
+
+	options.sampleRate = AUDIO_DEVICE_SAMPLE_RATE;
+	options.periodSizeInFrames = 0;
+	options.periods = 0;
+	options.lowLatency = 1;
+	options.backend = -1;
+	options.layout = AUDIO_LAYOUT_DEFAULT;
+
+	return options;
+}
+
+// Initialize miniaudio device with the given options, mixing callback included
+static ma_result InitAudioDevice(AudioDeviceOptions options, ma_device_type deviceType)
+{
+	ma_device_config config = ma_device_config_init(deviceType);
+	config.playback.pDeviceID = NULL;
+	config.playback.format = AUDIO_DEVICE_FORMAT;
+	config.playback.channels = (options.layout != AUDIO_LAYOUT_DEFAULT) ? (ma_uint32)options.layout : AUDIO_DEVICE_CHANNELS;
+	config.sampleRate = options.sampleRate;
+
+	// Capture is mono float, only opened to record the calibration loopback signal
+	if (deviceType == ma_device_type_duplex)
+	{
+		config.capture.pDeviceID = NULL;
+		config.capture.format = ma_format_f32;
+		config.capture.channels = 1;
+	}
+
+	config.periodSizeInFrames = options.periodSizeInFrames;
+	config.periods = options.periods;
+	config.performanceProfile = options.lowLatency ? ma_performance_profile_low_latency : ma_performance_profile_conservative;
+
+	// The mixer copes with any callback size, so skip the extra fixed-size intermediary buffer on low latency
+	config.noFixedSizedCallback = options.lowLatency ? MA_TRUE : MA_FALSE;
+
+	config.dataCallback = OnSendAudioDataToDevice;
+	config.pUserData = NULL;
+
+	return ma_device_init(&AUDIO.System.context, &config, &AUDIO.System.device);
+}
+
+void RiqInitAudioDeviceEx(AudioDeviceOptions options)
 {
 	ma_context_config ctxConfig = ma_context_config_init();
 	ma_log_callback_init(OnLog, NULL);
 
-	ma_result result = ma_context_init(NULL, 0, &ctxConfig, &AUDIO.System.context);
+	ma_result result = MA_ERROR;
+
+	// Only layouts with a mix kernel are accepted
+	if (GetChannelLayoutIndex((ma_uint32)options.layout) < 0)
+	{
+		if (options.layout != AUDIO_LAYOUT_DEFAULT) DEBUG_WARNING_FMT(unityLogPtr, "RIQAudio: Unsupported output layout (%i channels), using stereo", options.layout);
+		options.layout = AUDIO_LAYOUT_DEFAULT;
+	}
+
+	// Try the preferred backend first, if any, then fall back to the default priority order
+	if ((options.backend >= 0) && (options.backend < MA_BACKEND_COUNT))
+	{
+		ma_backend backend = (ma_backend)options.backend;
+
+		result = ma_context_init(&backend, 1, &ctxConfig, &AUDIO.System.context);
+		if (result != MA_SUCCESS) DEBUG_WARNING_FMT(unityLogPtr, "RIQAudio: Failed to initialize preferred backend (%s), using default", ma_get_backend_name(backend));
+	}
+
+	if (result != MA_SUCCESS) result = ma_context_init(NULL, 0, &ctxConfig, &AUDIO.System.context);
 	if (result != MA_SUCCESS)
 	{
 		DEBUG_LOG(unityLogPtr, "RIQAudio: Failed to initialize context!");
 		return;
 	}
 
-	// Initialize audio device
-	ma_device_config config = ma_device_config_init(ma_device_type_playback);
-	config.playback.pDeviceID = NULL;
-	config.playback.format = AUDIO_DEVICE_FORMAT;
-	config.playback.channels = AUDIO_DEVICE_CHANNELS;
-	
-	config.capture.pDeviceID = NULL;
-	config.capture.format = ma_format_s16;
-	config.capture.channels = 1;
-	config.sampleRate = AUDIO_DEVICE_SAMPLE_RATE;
+	// Locks must exist before the device starts firing the data callback
+	if (ma_mutex_init(&AUDIO.System.lock) != MA_SUCCESS)
+	{
+		DEBUG_ERROR(unityLogPtr, "RIQAudio: Failed to create mutex for mixing!");
 
-	config.dataCallback = OnSendAudioDataToDevice;
-	config.pUserData = NULL;
+		ma_context_uninit(&AUDIO.System.context);
+		return;
+	}
 
-	result = ma_device_init(&AUDIO.System.context, &config, &AUDIO.System.device);
-	if (result != MA_SUCCESS)
+	if (ma_mutex_init(&AUDIO.System.rebakeLock) != MA_SUCCESS)
 	{
-		DEBUG_ERROR(unityLogPtr, "RIQAudio: Failed to initialize playback device!");
+		DEBUG_ERROR(unityLogPtr, "RIQAudio: Failed to create mutex for sample rate changes!");
+
+		ma_mutex_uninit(&AUDIO.System.lock);
+		ma_context_uninit(&AUDIO.System.context);
 		return;
 	}
 
-	result = ma_device_start(&AUDIO.System.device);
+	// Initialize audio device
+	// NOTE: Playback only, capture is only opened while calibrating latency
+	result = InitAudioDevice(options, ma_device_type_playback);
 	if (result != MA_SUCCESS)
 	{
-		DEBUG_ERROR(unityLogPtr, "RIQAudio: Failed to start playback device!");
-		ma_device_uninit(&AUDIO.System.device);
+		DEBUG_ERROR(unityLogPtr, "RIQAudio: Failed to initialize playback device!");
+
+		ma_mutex_uninit(&AUDIO.System.rebakeLock);
+		ma_mutex_uninit(&AUDIO.System.lock);
 		ma_context_uninit(&AUDIO.System.context);
 		return;
 	}
 
-	if (ma_mutex_init(&AUDIO.System.lock) != MA_SUCCESS)
-	{
-		DEBUG_ERROR(unityLogPtr, "RIQAudio: Failed to create mutex for mixing!");
+	// Sounds loaded before a device re-initialization are adapted to the new sample rate
+	RebaseAudioBuffersSampleRate();
+
+	memset(&AUDIO.Stats, 0, sizeof(AUDIO.Stats));
 
+	// Offline device is never started, the mix is pulled with RiqRenderAudio()
+	result = AUDIO.System.offline ? MA_SUCCESS : ma_device_start(&AUDIO.System.device);
+	if (result != MA_SUCCESS)
+	{
+		DEBUG_ERROR(unityLogPtr, "RIQAudio: Failed to start playback device!");
 		ma_device_uninit(&AUDIO.System.device);
+		ma_mutex_uninit(&AUDIO.System.rebakeLock);
+		ma_mutex_uninit(&AUDIO.System.lock);
 		ma_context_uninit(&AUDIO.System.context);
 		return;
 	}
@@ -106,9 +215,114 @@ void RiqInitAudioDevice(void)
 		// AUDIO.MultiChannel.pool[i] = LoadAudioBuffer(AUDIO_DEVICE_FORMAT, AUDIO_DEVICE_CHANNELS, AUDIO.System.device.sampleRate, 0, 0);
 	}
 
+	AUDIO.commandBuffer.commands = (AudioCommand*)RIQ_CALLOC(AUDIO_COMMAND_BUFFER_CAPACITY, sizeof(AudioCommand));
+	AUDIO.commandBuffer.capacity = (AUDIO.commandBuffer.commands != NULL) ? AUDIO_COMMAND_BUFFER_CAPACITY : 0;
+	AUDIO.commandBuffer.count = 0;
+
+	AUDIO.System.options = options;
 	AUDIO.System.isReady = true;
 
-	DEBUG_LOG(unityLogPtr, "RIQAudio: Device initialized successfully!");
+	StartAudioBuffersRebake();
+
+	AudioDeviceInfo info = RiqGetAudioDeviceInfo();
+	DEBUG_LOG_FMT(unityLogPtr, "RIQAudio: Device initialized successfully! (%s, %i Hz, %i channels, period %i frames x %i, latency %.2f ms)", ma_get_backend_name(AUDIO.System.context.backend), info.sampleRate, info.channels, info.periodSizeInFrames, info.periods, info.latencyMs);
+}
+
+// Initialize audio system without a running device, nothing plays until the mix is pulled with RiqRenderAudio()
+// NOTE: Rendering is deterministic, useful for headless tests and offline bouncing
+void RiqInitAudioOffline(unsigned int sampleRate)
+{
+	AudioDeviceOptions options = RiqGetDefaultAudioDeviceOptions();
+	options.sampleRate = sampleRate;
+
+	RiqInitAudioOfflineEx(options);
+}
+
+// Offline mode with device options, the backend is always null and period options are ignored
+void RiqInitAudioOfflineEx(AudioDeviceOptions options)
+{
+	if (options.sampleRate == 0) options.sampleRate = 48000;
+	options.backend = (int)ma_backend_null;
+
+	AUDIO.System.offline = true;
+	RiqInitAudioDeviceEx(options);
+
+	if (!AUDIO.System.isReady) AUDIO.System.offline = false;
+}
+
+// Mix frameCount frames into framesOut (interleaved, device channels), offline mode only
+// NOTE: Render from a single thread, it stands for the audio thread and the callback epoch parity assumes
+// callbacks never overlap
+unsigned int RiqRenderAudio(float* framesOut, unsigned int frameCount)
+{
+	if (!AUDIO.System.isReady || !AUDIO.System.offline || (framesOut == NULL))
+	{
+		DEBUG_WARNING(unityLogPtr, "RIQAudio: Audio can only be rendered in offline mode");
+		return 0;
+	}
+
+	OnSendAudioDataToDevice(&AUDIO.System.device, framesOut, NULL, frameCount);
+
+	return frameCount;
+}
+
+AudioDeviceInfo RiqGetAudioDeviceInfo(void)
+{
+	AudioDeviceInfo info = { 0 };
+
+	if (AUDIO.System.isReady)
+	{
+		const ma_device* device = &AUDIO.System.device;
+
+		info.sampleRate = device->sampleRate;
+		info.channels = device->playback.channels;
+		info.periodSizeInFrames = device->playback.internalPeriodSizeInFrames;
+		info.periods = device->playback.internalPeriods;
+		info.internalSampleRate = device->playback.internalSampleRate;
+		info.backend = (int)AUDIO.System.context.backend;
+
+		// Backend buffer is periods * period size at the internal rate, plus the intermediary buffer
+		// used by miniaudio to guarantee fixed sized callbacks, if enabled
+		ma_uint64 backendFrames = (ma_uint64)info.periodSizeInFrames * info.periods;
+		if (info.internalSampleRate > 0) backendFrames = (backendFrames * info.sampleRate) / info.internalSampleRate;
+
+		info.latencyFrames = (unsigned int)backendFrames + device->playback.intermediaryBufferCap;
+		info.latencyMs = (info.sampleRate > 0) ? ((float)info.latencyFrames * 1000.0f / (float)info.sampleRate) : 0.0f;
+	}
+
+	return info;
+}
+
+AudioMixerStats RiqGetMixerStats(void)
+{
+	AudioMixerStats stats = { 0 };
+
+	if (!AUDIO.System.isReady) return stats;
+
+	ma_mutex_lock(&AUDIO.System.lock);
+	{
+		stats.callbackCount = AUDIO.Stats.callbackCount;
+		stats.framesMixed = AUDIO.Stats.framesMixed;
+		stats.buffersMixed = AUDIO.Stats.buffersMixed;
+		stats.maxBuffersMixed = AUDIO.Stats.maxBuffersMixed;
+		stats.overruns = AUDIO.Stats.overruns;
+		stats.lastCallbackMs = (float)((double)AUDIO.Stats.lastNs / 1000000.0);
+		stats.averageCallbackMs = (AUDIO.Stats.callbackCount > 0) ? (float)((double)AUDIO.Stats.totalNs / 1000000.0 / (double)AUDIO.Stats.callbackCount) : 0.0f;
+		stats.worstCallbackMs = (float)((double)AUDIO.Stats.worstNs / 1000000.0);
+		stats.worstLoad = AUDIO.Stats.worstLoad;
+	}
+	ma_mutex_unlock(&AUDIO.System.lock);
+
+	return stats;
+}
+
+void RiqResetMixerStats(void)
+{
+	if (!AUDIO.System.isReady) return;
+
+	ma_mutex_lock(&AUDIO.System.lock);
+	memset(&AUDIO.Stats, 0, sizeof(AUDIO.Stats));
+	ma_mutex_unlock(&AUDIO.System.lock);
 }
 
 bool IsRiqReady()
@@ -120,19 +334,175 @@ void RiqCloseAudioDevice(void)
 {
 	if (AUDIO.System.isReady)
 	{
-		ma_mutex_uninit(&AUDIO.System.lock);
+		StopAudioBuffersRebake();
+		StopAudioSpectrum();
+
 		ma_device_uninit(&AUDIO.System.device);
+
+		// Device is stopped, nothing can be mixing retired memory anymore
+		ReclaimRetiredAudioMemory(true);
+
+		ma_mutex_uninit(&AUDIO.System.rebakeLock);
+		ma_mutex_uninit(&AUDIO.System.lock);
 		ma_context_uninit(&AUDIO.System.context);
 
 		AUDIO.System.isReady = false;
+		AUDIO.System.offline = false;
 
 		RIQ_FREE(AUDIO.System.pcmBuffer);
 
+		RIQ_FREE(AUDIO.mixedProcessorChain.exchange(NULL));
+
+		RIQ_FREE(AUDIO.commandBuffer.commands);
+		AUDIO.commandBuffer.commands = NULL;
+		AUDIO.commandBuffer.capacity = 0;
+		AUDIO.commandBuffer.count = 0;
+
 		DEBUG_LOG(unityLogPtr, "RIQAudio: Device closed successfully!");
 	}
 	else DEBUG_ERROR(unityLogPtr, "RIQAudio: Device could not be closed, not currently initialized!");
 }
 
+// ================================================================================
+#pragma region Deferred Reclamation
+// ================================================================================
+
+// Memory unpublished from the audio thread, released once every callback that could still see it is done
+typedef struct RetiredMemory
+{
+	void* ptr;                      // Retired memory
+	void (*release)(void* ptr);     // Release function
+	unsigned int epoch;             // Audio callback epoch when the memory was retired
+	RetiredMemory* next;            // Next retired memory on the list
+} RetiredMemory;
+
+// Waits until the audio thread is done with any callback started before the caller published a change
+// NOTE: Never blocks the audio thread, only the caller spins while a callback is running
+static void WaitForAudioCallbackGrace(void)
+{
+	if (!AUDIO.System.isReady) return;
+
+	unsigned int epoch = AUDIO.System.callbackEpoch.load();
+
+	// Even epoch means no callback is running, the next one will see the new state
+	if ((epoch & 1) == 0) return;
+
+	while (AUDIO.System.callbackEpoch.load() == epoch) std::this_thread::yield();
+}
+
+// Check if the audio thread is past every callback running at the given epoch
+static bool IsAudioCallbackEpochPassed(unsigned int epoch)
+{
+	// Even epoch means no callback was running, the next one can't see the memory anymore
+	if ((epoch & 1) == 0) return true;
+
+	return (AUDIO.System.callbackEpoch.load() != epoch);
+}
+
+static void ReleaseMemory(void* ptr)
+{
+	RIQ_FREE(ptr);
+}
+
+// Queues memory to be released once the audio thread is done with it
+// NOTE: Memory must already be unreachable for callbacks starting from now on
+static void RetireAudioMemory(void* ptr, void (*release)(void* ptr))
+{
+	if (ptr == NULL) return;
+
+	// No device, no callback can be running
+	if (!AUDIO.System.isReady)
+	{
+		release(ptr);
+		return;
+	}
+
+	RetiredMemory* retired = (RetiredMemory*)RIQ_MALLOC(sizeof(RetiredMemory));
+	if (retired == NULL)
+	{
+		// Can't defer it, wait it out instead
+		WaitForAudioCallbackGrace();
+		release(ptr);
+		return;
+	}
+
+	retired->ptr = ptr;
+	retired->release = release;
+	retired->epoch = AUDIO.System.callbackEpoch.load();
+
+	ma_spinlock_lock(&AUDIO.Retire.lock);
+	{
+		retired->next = AUDIO.Retire.first;
+		AUDIO.Retire.first = retired;
+	}
+	ma_spinlock_unlock(&AUDIO.Retire.lock);
+}
+
+// Releases retired memory the audio thread is done with, everything if forced (device stopped)
+// NOTE: Never called from the audio thread, the mixer doesn't wait on this
+static void ReclaimRetiredAudioMemory(bool force)
+{
+	// Device stopped, queued buffers won't be unlinked by the mixer anymore
+	if (force) UnlinkUnloadedAudioBuffers();
+
+	// Buffers unlinked by the mixer are retired from here, the callback that unlinked them may still be running
+	AudioBuffer* unlinked = AUDIO.Unload.unlinked.exchange(NULL, std::memory_order_acquire);
+	while (unlinked != NULL)
+	{
+		AudioBuffer* buffer = unlinked;
+		unlinked = unlinked->nextUnloaded;
+
+		RetireAudioMemory(buffer, ReleaseAudioBuffer);
+	}
+
+	RetiredMemory* list = NULL;
+
+	ma_spinlock_lock(&AUDIO.Retire.lock);
+	{
+		list = AUDIO.Retire.first;
+		AUDIO.Retire.first = NULL;
+	}
+	ma_spinlock_unlock(&AUDIO.Retire.lock);
+
+	if (list == NULL) return;
+
+	RetiredMemory* pending = NULL;
+	RetiredMemory* pendingLast = NULL;
+
+	while (list != NULL)
+	{
+		RetiredMemory* retired = list;
+		list = list->next;
+
+		if (force || IsAudioCallbackEpochPassed(retired->epoch))
+		{
+			retired->release(retired->ptr);
+			RIQ_FREE(retired);
+		}
+		else
+		{
+			retired->next = pending;
+			if (pending == NULL) pendingLast = retired;
+			pending = retired;
+		}
+	}
+
+	// Still in use, back to the list
+	if (pending != NULL)
+	{
+		ma_spinlock_lock(&AUDIO.Retire.lock);
+		{
+			pendingLast->next = AUDIO.Retire.first;
+			AUDIO.Retire.first = pending;
+		}
+		ma_spinlock_unlock(&AUDIO.Retire.lock);
+	}
+}
+
+// ================================================================================
+#pragma endregion
+// ================================================================================
+
 // ================================================================================
 #pragma region AudioBuffer
 // ================================================================================
@@ -166,9 +536,19 @@ AudioBuffer* LoadAudioBuffer(ma_format format, ma_uint32 channels, ma_uint32 sam
 	audioBuffer->volume = 1.0f;
 	audioBuffer->pitch = 1.0f;
 	audioBuffer->pan = 0.5f;
+	audioBuffer->tempo = 1.0f;
+	audioBuffer->stretch = NULL;
+
+	audioBuffer->resampler = AUDIO_RESAMPLER_DEFAULT;
+	audioBuffer->resamplePhase = 0;
 
 	audioBuffer->callback = NULL;
 	audioBuffer->processor = NULL;
+	audioBuffer->processorChain = NULL;
+	audioBuffer->meter = NULL;
+
+	audioBuffer->unloading = false;
+	audioBuffer->nextUnloaded = NULL;
 
 	audioBuffer->playing = false;
 	audioBuffer->paused = false;
@@ -177,28 +557,70 @@ AudioBuffer* LoadAudioBuffer(ma_format format, ma_uint32 channels, ma_uint32 sam
 	audioBuffer->usage = usage;
 	audioBuffer->frameCursorPos = 0;
 	audioBuffer->sizeInFrames = sizeInFrames;
+	audioBuffer->sampleRate = sampleRate;
 
 	// Buffers should be marked as processed by default so that a call to
 	// UpdateAudioStream() immediately after initialization works correctly
 	audioBuffer->isSubBufferProcessed[0] = true;
 	audioBuffer->isSubBufferProcessed[1] = true;
 
+	audioBuffer->handle = 0;
+
 	TrackAudioBuffer(audioBuffer);
 
 	return audioBuffer;
 }
 
+static void ReleaseAudioBuffer(void* ptr);
+static void UnloadTimeStretch(void* ptr);
+static void LoadAudioBufferTimeStretches(const AudioCommand* commands, unsigned int count);
+static void DetachAudioBufferEffects(AudioBuffer* buffer);
+
+// Unloading never takes the mixing lock while the device is running: the buffer is marked and queued, the
+// mixer unlinks it on its next callback and the next reclaim retires it (see UnlinkUnloadedAudioBuffers)
 void UnloadAudioBuffer(AudioBuffer* buffer)
 {
 	if (buffer != NULL)
 	{
-		ma_data_converter_uninit(&buffer->converter, NULL);
-		UntrackAudioBuffer(buffer);
-		RIQ_FREE(buffer->data);
-		RIQ_FREE(buffer);
+		if (!AUDIO.System.isReady)
+		{
+			UntrackAudioBuffer(buffer);
+			DetachAudioBufferEffects(buffer);
+			ReleaseAudioBuffer(buffer);
+			return;
+		}
+
+		// Wait for the buffer to be left alone by the rebake thread, if running, handle lookups fail from now on
+		ma_mutex_lock(&AUDIO.System.rebakeLock);
+		buffer->unloading.store(true);
+		ma_mutex_unlock(&AUDIO.System.rebakeLock);
+
+		DetachAudioBufferEffects(buffer);
+
+		AudioBuffer* first = AUDIO.Unload.pending.load(std::memory_order_relaxed);
+		do buffer->nextUnloaded = first;
+		while (!AUDIO.Unload.pending.compare_exchange_weak(first, buffer, std::memory_order_release, std::memory_order_relaxed));
+
+		ReclaimRetiredAudioMemory(false);
 	}
 }
 
+// Releases buffer memory, buffer must be untracked and retired first
+static void ReleaseAudioBuffer(void* ptr)
+{
+	AudioBuffer* buffer = (AudioBuffer*)ptr;
+
+	RIQ_FREE(buffer->processorChain.load());
+	RIQ_FREE(buffer->meter.load());
+	UnloadTimeStretch(buffer->stretch);
+
+	ma_data_converter_uninit(&buffer->converter, NULL);
+	RIQ_FREE(buffer->silence.spans);
+	if (!buffer->source.shared) RIQ_FREE(buffer->source.data);
+	if (!buffer->sharedData) RIQ_FREE(buffer->data);
+	RIQ_FREE(buffer);
+}
+
 bool IsAudioBufferPlaying(AudioBuffer* buffer)
 {
 	bool result = false;
@@ -208,6 +630,7 @@ bool IsAudioBufferPlaying(AudioBuffer* buffer)
 	return result;
 }
 
+// Play, stop, pause and resume are called with the mixing lock held (or no device), cursor fields are shared with the mixer
 void PlayAudioBuffer(AudioBuffer* buffer)
 {
 	if (buffer != NULL)
@@ -215,6 +638,9 @@ void PlayAudioBuffer(AudioBuffer* buffer)
 		buffer->playing = true;
 		buffer->paused = false;
 		buffer->frameCursorPos = 0;
+		buffer->resamplePhase = 0;
+
+		if (buffer->silence.leadFrames > 0) StartAudioBufferLeadDelay(buffer);
 	}
 }
 
@@ -227,6 +653,8 @@ void StopAudioBuffer(AudioBuffer* buffer)
 			buffer->playing = false;
 			buffer->paused = false;
 			buffer->frameCursorPos = 0;
+			buffer->resamplePhase = 0;
+			buffer->silence.delayFrames = 0;
 			buffer->framesProcessed = 0;
 			buffer->isSubBufferProcessed[0] = true;
 			buffer->isSubBufferProcessed[1] = true;
@@ -244,241 +672,3671 @@ void ResumeAudioBuffer(AudioBuffer* buffer)
 	if (buffer != NULL) buffer->paused = false;
 }
 
+void SetAudioBufferVolume(AudioBuffer* buffer, float volume)
+{
+	if (buffer != NULL) buffer->volume = volume;
+}
+
+void SetAudioBufferPitch(AudioBuffer* buffer, float pitch)
+{
+	if ((buffer != NULL) && (pitch > 0.0f))
+	{
+		// Pitching is just an adjustment of the sample rate
+		// NOTE: Output rate is always derived from the device rate, so pitch changes don't compound
+		ma_uint32 outputSampleRate = (ma_uint32)((float)AUDIO.System.device.sampleRate / pitch);
+		ma_data_converter_set_rate(&buffer->converter, buffer->sampleRate, outputSampleRate);
+
+		buffer->pitch = pitch;
+	}
+}
+
+void SetAudioBufferPan(AudioBuffer* buffer, float pan)
+{
+	if (pan < 0.0f) pan = 0.0f;
+	else if (pan > 1.0f) pan = 1.0f;
+
+	if (buffer != NULL) buffer->pan = pan;
+}
+
+// NOTE: Buffers are also tracked and untracked while the device is closed, the mixing lock only exists while it is ready
 void TrackAudioBuffer(AudioBuffer* buffer)
 {
-	ma_mutex_lock(&AUDIO.System.lock);
+	const bool locked = AUDIO.System.isReady;
+	if (locked) ma_mutex_lock(&AUDIO.System.lock);
+	{
+		if (AUDIO.Buffer.first == NULL) AUDIO.Buffer.first = buffer;
+		else
+		{
+			AUDIO.Buffer.last->next = buffer;
+			buffer->prev = AUDIO.Buffer.last;
+		}
+
+		AUDIO.Buffer.last = buffer;
+
+		// Handle layout: generation in the high 16 bits, slot index in the low 16 bits
+		int index = -1;
+		if (AUDIO.Handle.freeCount > 0) index = AUDIO.Handle.freeIndices[--AUDIO.Handle.freeCount];
+		else if (AUDIO.Handle.nextIndex < MAX_AUDIO_BUFFER_HANDLES) index = AUDIO.Handle.nextIndex++;
+
+		if (index >= 0)
+		{
+			// Generation 0 is skipped so a valid handle is never 0
+			if (++AUDIO.Handle.generations[index] == 0) AUDIO.Handle.generations[index] = 1;
+
+			AUDIO.Handle.slots[index] = buffer;
+			buffer->handle = ((unsigned int)AUDIO.Handle.generations[index] << 16) | index;
+		}
+	}
+	if (locked) ma_mutex_unlock(&AUDIO.System.lock);
+}
+
+// Removes a buffer from the list and the handle table, caller holds the mixing lock or nothing is mixing
+static void UnlinkAudioBuffer(AudioBuffer* buffer)
+{
+	if (buffer->prev == NULL) AUDIO.Buffer.first = buffer->next;
+	else buffer->prev->next = buffer->next;
+
+	if (buffer->next == NULL) AUDIO.Buffer.last = buffer->prev;
+	else buffer->next->prev = buffer->prev;
+
+	buffer->prev = NULL;
+	buffer->next = NULL;
+
+	if (buffer->handle != 0)
+	{
+		unsigned short index = (unsigned short)(buffer->handle & 0xFFFF);
+
+		AUDIO.Handle.slots[index] = NULL;
+		AUDIO.Handle.freeIndices[AUDIO.Handle.freeCount++] = index;
+		buffer->handle = 0;
+	}
+}
+
+void UntrackAudioBuffer(AudioBuffer* buffer)
+{
+	const bool locked = AUDIO.System.isReady;
+	if (locked) ma_mutex_lock(&AUDIO.System.lock);
+	UnlinkAudioBuffer(buffer);
+	if (locked) ma_mutex_unlock(&AUDIO.System.lock);
+}
+
+// Unlinks every queued unloaded buffer and hands them over to be retired, called by the mixer under its lock
+// NOTE: No allocation nor lock, the audio thread only swaps the queues. Also called on close, with the device stopped
+static void UnlinkUnloadedAudioBuffers(void)
+{
+	AudioBuffer* list = AUDIO.Unload.pending.exchange(NULL, std::memory_order_acquire);
+	if (list == NULL) return;
+
+	AudioBuffer* last = list;
+	for (AudioBuffer* buffer = list; buffer != NULL; buffer = buffer->nextUnloaded)
+	{
+		UnlinkAudioBuffer(buffer);
+		last = buffer;
+	}
+
+	AudioBuffer* first = AUDIO.Unload.unlinked.load(std::memory_order_relaxed);
+	do last->nextUnloaded = first;
+	while (!AUDIO.Unload.unlinked.compare_exchange_weak(first, list, std::memory_order_release, std::memory_order_relaxed));
+}
+
+// Get audio buffer from a handle, NULL if the handle is stale or invalid
+// NOTE: Must be called with AUDIO.System.lock held
+AudioBuffer* GetAudioBufferFromHandle(unsigned int handle)
+{
+	unsigned int index = handle & 0xFFFF;
+
+	if ((handle == 0) || (index >= MAX_AUDIO_BUFFER_HANDLES)) return NULL;
+	if (AUDIO.Handle.generations[index] != (unsigned short)(handle >> 16)) return NULL;
+
+	// Unloaded buffers keep their slot until the mixer unlinks them
+	AudioBuffer* buffer = AUDIO.Handle.slots[index];
+	if ((buffer != NULL) && buffer->unloading.load(std::memory_order_relaxed)) return NULL;
+
+	return buffer;
+}
+
+// Rebake thread state, only touched from the game thread
+static std::thread rebakeThread;
+static std::atomic<bool> rebakeCancel(false);
+static std::vector<unsigned int> rebakeHandles;
+
+// Adapts every tracked buffer to the current device sample rate, data is resampled at mixing time
+// until the rebake thread re-derives it at the new rate
+// NOTE: Called before the device is started, so nothing is mixing yet
+static void RebaseAudioBuffersSampleRate(void)
+{
+	rebakeHandles.clear();
+
+	for (AudioBuffer* buffer = AUDIO.Buffer.first; buffer != NULL; buffer = buffer->next)
+	{
+		// Output rate follows the device rate, input rate is still the one data was baked at
+		SetAudioBufferPitch(buffer, buffer->pitch);
+
+		if ((buffer->source.data != NULL) && (buffer->handle != 0) && !buffer->unloading && (buffer->sampleRate != AUDIO.System.device.sampleRate))
+		{
+			rebakeHandles.push_back(buffer->handle);
+		}
+	}
+}
+
+// Re-derives buffers data from their source copy at the device sample rate, runs on the rebake thread
+static void RebakeAudioBuffers(void)
+{
+	const ma_uint32 sampleRate = AUDIO.System.device.sampleRate;
+
+	for (unsigned int handle : rebakeHandles)
+	{
+		if (rebakeCancel) break;
+
+		// Holding the rebake lock keeps the buffer from being unloaded while its data is converted
+		ma_mutex_lock(&AUDIO.System.rebakeLock);
+		{
+			ma_mutex_lock(&AUDIO.System.lock);
+			AudioBuffer* buffer = GetAudioBufferFromHandle(handle);
+			ma_mutex_unlock(&AUDIO.System.lock);
+
+			if ((buffer != NULL) && (buffer->source.data != NULL))
+			{
+				ma_uint32 frameCount = (ma_uint32)ma_convert_frames(NULL, 0, AUDIO_DEVICE_FORMAT, AUDIO_DEVICE_CHANNELS, sampleRate, NULL, buffer->source.frameCount, buffer->source.format, buffer->source.channels, buffer->source.sampleRate);
+				unsigned char* data = (frameCount > 0) ? (unsigned char*)RIQ_CALLOC(frameCount * AUDIO_DEVICE_CHANNELS * ma_get_bytes_per_sample(AUDIO_DEVICE_FORMAT), 1) : NULL;
+
+				if (data != NULL)
+				{
+					frameCount = (ma_uint32)ma_convert_frames(data, frameCount, AUDIO_DEVICE_FORMAT, AUDIO_DEVICE_CHANNELS, sampleRate, buffer->source.data, buffer->source.frameCount, buffer->source.format, buffer->source.channels, buffer->source.sampleRate);
+
+					unsigned int spanCount = 0;
+					SilenceSpan* spans = (buffer->silence.threshold > 0.0f) ? LoadSilenceSpans((const float*)data, AUDIO_DEVICE_CHANNELS, frameCount, buffer->silence.threshold, &spanCount) : NULL;
+
+					unsigned char* oldData = buffer->data;
+					SilenceSpan* oldSpans = buffer->silence.spans;
+
+					// Swap data while the mixer is out, cursor keeps the same relative position
+					ma_mutex_lock(&AUDIO.System.lock);
+					{
+						// Direct resampler fraction is rescaled along with the cursor
+						if (buffer->sizeInFrames > 0)
+						{
+							double position = ((double)buffer->frameCursorPos + (double)buffer->resamplePhase / 4294967296.0) * (double)frameCount / (double)buffer->sizeInFrames;
+
+							buffer->frameCursorPos = (ma_uint32)position;
+							buffer->resamplePhase = (unsigned int)((position - (double)buffer->frameCursorPos) * 4294967296.0);
+						}
+
+						if (buffer->frameCursorPos >= frameCount)
+						{
+							buffer->frameCursorPos = 0;
+							buffer->resamplePhase = 0;
+						}
+
+						if (buffer->sharedData) oldData = NULL;
+
+						// Rescaled from the source rate offset, rescaling the previous one would drift on every device change
+						buffer->silence.leadFrames = (unsigned int)(((ma_uint64)buffer->silence.sourceLeadFrames * sampleRate) / buffer->source.sampleRate);
+						buffer->silence.spans = spans;
+						buffer->silence.spanCount = spanCount;
+
+						buffer->data = data;
+						buffer->sharedData = false;
+						buffer->sizeInFrames = frameCount;
+						buffer->sampleRate = sampleRate;
+
+						ma_data_converter_set_rate(&buffer->converter, sampleRate, (ma_uint32)((float)sampleRate / buffer->pitch));
+					}
+					ma_mutex_unlock(&AUDIO.System.lock);
+
+					RIQ_FREE(oldData);
+					RIQ_FREE(oldSpans);
+				}
+				else DEBUG_WARNING(unityLogPtr, "AUDIO: Failed to re-derive buffer data for new sample rate");
+			}
+		}
+		ma_mutex_unlock(&AUDIO.System.rebakeLock);
+	}
+}
+
+static void StartAudioBuffersRebake(void)
+{
+	if (rebakeHandles.empty()) return;
+
+	DEBUG_LOG_FMT(unityLogPtr, "AUDIO: Device sample rate changed, re-deriving %i sounds in background", (int)rebakeHandles.size());
+
+	rebakeCancel = false;
+	rebakeThread = std::thread(RebakeAudioBuffers);
+}
+
+static void StopAudioBuffersRebake(void)
+{
+	if (rebakeThread.joinable())
+	{
+		rebakeCancel = true;
+		rebakeThread.join();
+	}
+}
+
+// ================================================================================
+#pragma endregion
+// ================================================================================
+
+// ================================================================================
+#pragma region Silence
+// ================================================================================
+
+// Get sample value as float, format is resolved at compile time so scans don't dispatch per sample
+template <ma_format Format>
+static inline float GetSilenceSampleValue(const void* data, ma_uint64 index)
+{
+	if constexpr (Format == ma_format_u8) return ((float)((const ma_uint8*)data)[index] - 128.0f) / 128.0f;
+	else if constexpr (Format == ma_format_s16) return (float)((const ma_int16*)data)[index] / 32768.0f;
+	else return ((const float*)data)[index];
+}
+
+template <ma_format Format>
+static inline bool IsSilentFrame(const void* data, ma_uint32 channels, ma_uint32 frame, float threshold)
+{
+	for (ma_uint32 c = 0; c < channels; c++)
+	{
+		if (fabsf(GetSilenceSampleValue<Format>(data, (ma_uint64)frame * channels + c)) > threshold) return false;
+	}
+
+	return true;
+}
+
+template <ma_format Format>
+static ma_uint32 GetLeadingSilenceFramesFormat(const void* data, ma_uint32 channels, ma_uint32 frameCount, float threshold)
+{
+	ma_uint32 frame = 0;
+	while ((frame < frameCount) && IsSilentFrame<Format>(data, channels, frame, threshold)) frame++;
+
+	return frame;
+}
+
+template <ma_format Format>
+static ma_uint32 GetTrailingSilenceFramesFormat(const void* data, ma_uint32 channels, ma_uint32 frameCount, float threshold)
+{
+	ma_uint32 frame = frameCount;
+	while ((frame > 0) && IsSilentFrame<Format>(data, channels, frame - 1, threshold)) frame--;
+
+	return frameCount - frame;
+}
+
+// Get number of silent frames at the start of data
+static ma_uint32 GetLeadingSilenceFrames(const void* data, ma_format format, ma_uint32 channels, ma_uint32 frameCount, float threshold)
+{
+	switch (format)
+	{
+		case ma_format_u8: return GetLeadingSilenceFramesFormat<ma_format_u8>(data, channels, frameCount, threshold);
+		case ma_format_s16: return GetLeadingSilenceFramesFormat<ma_format_s16>(data, channels, frameCount, threshold);
+		case ma_format_f32: return GetLeadingSilenceFramesFormat<ma_format_f32>(data, channels, frameCount, threshold);
+		default: return 0;
+	}
+}
+
+// Get number of silent frames at the end of data
+static ma_uint32 GetTrailingSilenceFrames(const void* data, ma_format format, ma_uint32 channels, ma_uint32 frameCount, float threshold)
+{
+	switch (format)
+	{
+		case ma_format_u8: return GetTrailingSilenceFramesFormat<ma_format_u8>(data, channels, frameCount, threshold);
+		case ma_format_s16: return GetTrailingSilenceFramesFormat<ma_format_s16>(data, channels, frameCount, threshold);
+		case ma_format_f32: return GetTrailingSilenceFramesFormat<ma_format_f32>(data, channels, frameCount, threshold);
+		default: return 0;
+	}
+}
+
+// Builds the run-length map of silent spans of a static buffer data, spans shorter than AUDIO_SILENCE_MIN_SPAN_FRAMES are ignored
+// NOTE: Data is scanned once, spans are gathered in a scratch vector and copied to a single allocation
+static SilenceSpan* LoadSilenceSpans(const float* data, ma_uint32 channels, ma_uint32 frameCount, float threshold, unsigned int* spanCount)
+{
+	std::vector<SilenceSpan> found;
+	ma_uint32 start = 0;
+	bool silent = false;
+
+	*spanCount = 0;
+
+	for (ma_uint32 frame = 0; frame <= frameCount; frame++)
+	{
+		bool frameSilent = (frame < frameCount) && IsSilentFrame<ma_format_f32>(data, channels, frame, threshold);
+
+		if (frameSilent && !silent) start = frame;
+		else if (!frameSilent && silent && ((frame - start) >= AUDIO_SILENCE_MIN_SPAN_FRAMES))
+		{
+			SilenceSpan span = { 0 };
+			span.start = start;
+			span.length = frame - start;
+			found.push_back(span);
+		}
+
+		silent = frameSilent;
+	}
+
+	if (found.empty()) return NULL;
+
+	SilenceSpan* spans = (SilenceSpan*)RIQ_MALLOC(found.size() * sizeof(SilenceSpan));
+	if (spans == NULL) return NULL;
+
+	memcpy(spans, found.data(), found.size() * sizeof(SilenceSpan));
+	*spanCount = (unsigned int)found.size();
+
+	return spans;
+}
+
+// Find first silent span that ends after frame
+static unsigned int FindSilenceSpan(const AudioBuffer* buffer, ma_uint64 frame)
+{
+	unsigned int low = 0;
+	unsigned int high = buffer->silence.spanCount;
+
+	while (low < high)
+	{
+		unsigned int mid = (low + high) / 2;
+
+		if (((ma_uint64)buffer->silence.spans[mid].start + buffer->silence.spans[mid].length) <= frame) low = mid + 1;
+		else high = mid;
+	}
+
+	return low;
+}
+
+// Get the converter linear resampler when a trimmed buffer starts on it, NULL when a direct resampler or the stretcher plays it
+static const ma_linear_resampler* GetAudioBufferLeadResampler(const AudioBuffer* buffer)
+{
+	if ((buffer->resampler != AUDIO_RESAMPLER_CONVERTER) || ((buffer->stretch != NULL) && (buffer->tempo != 1.0f))) return NULL;
+	if (!buffer->converter.hasResampler || (buffer->converter.resampler.pBackend != &buffer->converter.resampler.state.linear)) return NULL;
+	if (buffer->converter.resampler.state.linear.config.format != ma_format_f32) return NULL;
+
+	return &buffer->converter.resampler.state.linear;
+}
+
+// Get output frames left before a trimmed buffer data starts playing
+static ma_uint32 GetAudioBufferLeadDelay(const AudioBuffer* buffer)
+{
+	// Converter rates are exact, its delay is counted with them so it matches the converter timer
+	const ma_linear_resampler* resampler = GetAudioBufferLeadResampler(buffer);
+	if (resampler != NULL)
+	{
+		const ma_uint64 rateIn = resampler->config.sampleRateIn;
+		const ma_uint64 rateOut = resampler->config.sampleRateOut;
+
+		return (ma_uint32)(((ma_uint64)buffer->silence.leadFrames * rateOut + rateIn - 1) / rateIn);
+	}
+
+	double ratio = ((double)buffer->sampleRate / (double)AUDIO.System.device.sampleRate) * (double)buffer->pitch;
+	if ((buffer->stretch != NULL) && (buffer->tempo != 1.0f)) ratio *= buffer->tempo;
+
+	return (ratio > 0.0) ? (ma_uint32)ceil((double)buffer->silence.leadFrames / ratio) : 0;
+}
+
+// Starts the play delay of a trimmed buffer, the delay rounds up to whole output frames
+// and the resampler starts at the matching fractional position, so timing stays exact
+static void StartAudioBufferLeadDelay(AudioBuffer* buffer)
+{
+	buffer->silence.delayFrames = GetAudioBufferLeadDelay(buffer);
+
+	// Converter timer restarts at the position, in input frames of 1/rateOut, with the previous frames cleared as a fresh one
+	// NOTE: Filter state is kept as untrimmed playback does, the resampler reset would clear its cache and this miniaudio version clears it wrong
+	if (GetAudioBufferLeadResampler(buffer) != NULL)
+	{
+		ma_linear_resampler* resampler = &buffer->converter.resampler.state.linear;
+		const ma_uint64 rateIn = resampler->config.sampleRateIn;
+		const ma_uint64 rateOut = resampler->config.sampleRateOut;
+		const ma_uint64 offset = (ma_uint64)buffer->silence.delayFrames * rateIn - (ma_uint64)buffer->silence.leadFrames * rateOut;
+
+		resampler->inTimeInt = 1;
+		resampler->inTimeFrac = 0;
+
+		for (ma_uint32 c = 0; c < resampler->config.channels; c++)
+		{
+			resampler->x0.f32[c] = 0.0f;
+			resampler->x1.f32[c] = 0.0f;
+		}
+
+		if ((offset / rateOut) < buffer->sizeInFrames)
+		{
+			buffer->frameCursorPos = (ma_uint32)(offset / rateOut);
+			resampler->inTimeFrac = (ma_uint32)(offset % rateOut);
+		}
+
+		return;
+	}
+
+	const double ratio = ((double)buffer->sampleRate / (double)AUDIO.System.device.sampleRate) * (double)buffer->pitch;
+	const ma_uint64 step = (ma_uint64)(ratio * 4294967296.0);
+	const ma_uint64 lead = (ma_uint64)buffer->silence.leadFrames << 32;
+	const ma_uint64 delay = (ma_uint64)buffer->silence.delayFrames * step;
+
+	if ((buffer->stretch == NULL || buffer->tempo == 1.0f) && (delay > lead) && ((delay - lead) >> 32) < buffer->sizeInFrames)
+	{
+		buffer->frameCursorPos = (ma_uint32)((delay - lead) >> 32);
+		buffer->resamplePhase = (ma_uint32)((delay - lead) & 0xFFFFFFFF);
+	}
+}
+
+unsigned int RiqGetSoundTrimOffset(Sound sound)
+{
+	return (sound.stream.buffer != NULL) ? sound.stream.buffer->silence.leadFrames : 0;
+}
+
+// ================================================================================
+#pragma endregion
+// ================================================================================
+
+// ================================================================================
+#pragma region Sound
+// ================================================================================
+
+Sound RiqLoadSound(const char* filePath)
+{
+	Wave wave = RiqLoadWave(filePath);
+
+	Sound sound = RiqLoadSoundFromWave(wave);
+
+	RiqUnloadWave(wave);
+
+	return sound;
+}
+
+
+Sound RiqLoadSoundTrimmed(const char* filePath, float thresholdDb)
+{
+	Wave wave = RiqLoadWave(filePath);
+
+	Sound sound = RiqLoadSoundFromWaveTrimmed(wave, thresholdDb);
+
+	RiqUnloadWave(wave);
+
+	return sound;
+}
+
+Sound RiqLoadSoundFromWave(Wave wave)
+{
+	return LoadSoundFromWaveEx(wave, AUDIO_SILENCE_THRESHOLD_DB, false);
+}
+
+// Load sound with its leading and trailing silence below thresholdDb removed,
+// leading silence is kept as a play delay so timing stays exact
+Sound RiqLoadSoundFromWaveTrimmed(Wave wave, float thresholdDb)
+{
+	return LoadSoundFromWaveEx(wave, thresholdDb, true);
+}
+
+// Load sound from wave, silent spans below thresholdDb are mapped so the mixer can skip them
+static Sound LoadSoundFromWaveEx(Wave wave, float thresholdDb, bool trim)
+{
+	Sound sound = { 0 };
+
+	if (wave.data != NULL)
+	{
+		// When using miniaudio we need to do our own mixing.
+		// To simplify this we need convert the format of each sound to be consistent with
+		// the format used to open the playback AUDIO.System.device. We can do this two ways:
+		//
+		//   1) Convert the whole sound in one go at load time (here).
+		//   2) Convert the audio data in chunks at mixing time.
+		//
+		// First option has been selected, format conversion is done on the loading stage.
+		// The downside is that it uses more memory if the original sound is u8 or s16.
+		ma_format formatIn = ((wave.sampleSize == 8) ? ma_format_u8 : ((wave.sampleSize == 16) ? ma_format_s16 : ma_format_f32));
+		float threshold = powf(10.0f, thresholdDb / 20.0f);
+		ma_uint32 leadFrames = 0;
+
+		if (trim && (wave.frameCount > 0))
+		{
+			// At least one frame is kept, so a fully silent sound still plays (silently) for the right time
+			leadFrames = GetLeadingSilenceFrames(wave.data, formatIn, wave.channels, wave.frameCount, threshold);
+			if (leadFrames == wave.frameCount) leadFrames = wave.frameCount - 1;
+
+			// A couple of silent frames are kept before the data, interpolation taps reach them when playing pitched
+			leadFrames = (leadFrames > 2) ? leadFrames - 2 : 0;
+
+			ma_uint32 tailFrames = GetTrailingSilenceFrames((unsigned char*)wave.data + (size_t)leadFrames * wave.channels * ma_get_bytes_per_sample(formatIn), formatIn, wave.channels, wave.frameCount - leadFrames, threshold);
+			if (tailFrames == wave.frameCount - leadFrames) tailFrames = 0;
+
+			// Same margin after the data, it flushes the converter latency frame and feeds the last interpolation taps
+			tailFrames = (tailFrames > 2) ? tailFrames - 2 : 0;
+
+			wave.data = (unsigned char*)wave.data + (size_t)leadFrames * wave.channels * ma_get_bytes_per_sample(formatIn);
+			wave.frameCount -= leadFrames + tailFrames;
+
+			if ((leadFrames > 0) || (tailFrames > 0)) DEBUG_LOG_FMT(unityLogPtr, "SOUND: Trimmed %i leading and %i trailing silent frames", (int)leadFrames, (int)tailFrames);
+		}
+
+		ma_uint32 frameCountIn = wave.frameCount;
+
+		ma_uint32 frameCount = (ma_uint32)ma_convert_frames(NULL, 0, AUDIO_DEVICE_FORMAT, AUDIO_DEVICE_CHANNELS, AUDIO.System.device.sampleRate, NULL, frameCountIn, formatIn, wave.channels, wave.sampleRate);
+		if (frameCount == 0) DEBUG_WARNING(unityLogPtr, "SOUND: Failed to get frame count for format conversion");
+
+		AudioBuffer* audioBuffer = LoadAudioBuffer(AUDIO_DEVICE_FORMAT, AUDIO_DEVICE_CHANNELS, AUDIO.System.device.sampleRate, frameCount, AUDIO_BUFFER_USAGE_STATIC);
+		if (audioBuffer == NULL)
+		{
+			DEBUG_WARNING(unityLogPtr, "SOUND: Failed to create buffer");
+			return sound; // Early return to avoid dereferencing the audioBuffer null pointer.
+		}
+
+		frameCount = (ma_uint32)ma_convert_frames(audioBuffer->data, frameCount, AUDIO_DEVICE_FORMAT, AUDIO_DEVICE_CHANNELS, AUDIO.System.device.sampleRate, wave.data, frameCountIn, formatIn, wave.channels, wave.sampleRate);
+		if (frameCount == 0) DEBUG_WARNING(unityLogPtr, "SOUND: Failed format conversion");
+
+		// Trimmed offset is kept at data rate, source rate one is kept for rebakes
+		audioBuffer->silence.leadFrames = (unsigned int)(((ma_uint64)leadFrames * AUDIO.System.device.sampleRate) / wave.sampleRate);
+		audioBuffer->silence.sourceLeadFrames = leadFrames;
+
+		// Spans are only mapped for trimmed sounds unless skipping is enabled for all, threshold stays 0 otherwise so rebakes skip them too
+		if (trim || AUDIO_SILENCE_SKIP)
+		{
+			audioBuffer->silence.threshold = threshold;
+			audioBuffer->silence.spans = LoadSilenceSpans((const float*)audioBuffer->data, AUDIO_DEVICE_CHANNELS, frameCount, threshold, &audioBuffer->silence.spanCount);
+		}
+
+#if AUDIO_KEEP_SOURCE_DATA
+		// Source data is kept in its original (usually 16bit) format, so a device sample rate change
+		// re-derives the sound from it instead of resampling already resampled data
+		size_t sourceSize = (size_t)frameCountIn * wave.channels * ma_get_bytes_per_sample(formatIn);
+
+		audioBuffer->source.data = RIQ_MALLOC(sourceSize);
+		if (audioBuffer->source.data != NULL)
+		{
+			memcpy(audioBuffer->source.data, wave.data, sourceSize);
+			audioBuffer->source.format = formatIn;
+			audioBuffer->source.channels = wave.channels;
+			audioBuffer->source.sampleRate = wave.sampleRate;
+			audioBuffer->source.frameCount = frameCountIn;
+		}
+#endif
+
+		sound.frameCount = frameCount;
+		sound.stream.sampleRate = AUDIO.System.device.sampleRate;
+		sound.stream.sampleSize = 32;
+		sound.stream.channels = AUDIO_DEVICE_CHANNELS;
+		sound.stream.buffer = audioBuffer;
+	}
+
+	return sound;
+}
+
+void RiqUnloadSound(Sound sound)
+{
+	UnloadAudioBuffer(sound.stream.buffer);
+}
+
+
+void RiqPlaySound(Sound sound)
+{
+	// Cursor and delay are also written by the mixer, reset them while it is out
+	const bool locked = AUDIO.System.isReady;
+	if (locked) ma_mutex_lock(&AUDIO.System.lock);
+	PlayAudioBuffer(sound.stream.buffer);
+	if (locked) ma_mutex_unlock(&AUDIO.System.lock);
+}
+
+unsigned int RiqGetSoundHandle(Sound sound)
+{
+	return (sound.stream.buffer != NULL) ? sound.stream.buffer->handle : 0;
+}
+
+// ================================================================================
+#pragma endregion
+// ================================================================================
+
+// ================================================================================
+#pragma region Sound Bank
+// ================================================================================
+
+// Get sample format from a bank entry sample size
+static ma_format GetSoundBankEntryFormat(const SoundBankEntry* entry)
+{
+	return ((entry->sampleSize == 8) ? ma_format_u8 : ((entry->sampleSize == 16) ? ma_format_s16 : ((entry->sampleSize == 32) ? ma_format_f32 : ma_format_unknown)));
+}
+
+// Check if a bank entry is already in device format, so a sound can play straight from the file data
+static bool IsSoundBankEntryInDeviceFormat(const SoundBankEntry* entry)
+{
+	return ((GetSoundBankEntryFormat(entry) == AUDIO_DEVICE_FORMAT) && (entry->channels == AUDIO_DEVICE_CHANNELS) && (entry->sampleRate == AUDIO.System.device.sampleRate));
+}
+
+// Load sound bank from file data, bank takes ownership of fileData
+static SoundBank LoadSoundBankFromData(unsigned char* fileData, unsigned int dataSize)
+{
+	SoundBank bank = { 0 };
+
+	const SoundBankHeader* header = (const SoundBankHeader*)fileData;
+
+	if ((dataSize < sizeof(SoundBankHeader)) || (memcmp(header->magic, "RIQB", 4) != 0) || (header->version != SOUND_BANK_VERSION))
+	{
+		DEBUG_WARNING(unityLogPtr, "SOUNDBANK: Data is not a valid sound bank");
+		RIQ_FREE(fileData);
+		return bank;
+	}
+
+	const ma_uint64 indexEnd = sizeof(SoundBankHeader) + (ma_uint64)header->soundCount * sizeof(SoundBankEntry);
+
+	if ((header->soundCount == 0) || (indexEnd > header->dataOffset) || ((ma_uint64)header->dataOffset + header->dataSize > dataSize))
+	{
+		DEBUG_WARNING(unityLogPtr, "SOUNDBANK: Sound bank index is corrupted");
+		RIQ_FREE(fileData);
+		return bank;
+	}
+
+	const SoundBankEntry* entries = (const SoundBankEntry*)(fileData + sizeof(SoundBankHeader));
+
+	// Validate every entry and size the converted sample block, entries already in device format need no space
+	ma_uint64 convertedSize = 0;
+	bool keepFileData = (AUDIO_KEEP_SOURCE_DATA != 0);
+
+	for (unsigned int i = 0; i < header->soundCount; i++)
+	{
+		const SoundBankEntry* entry = &entries[i];
+		ma_format format = GetSoundBankEntryFormat(entry);
+
+		// Samples are read in place as their sample type, the exporter aligns every slice
+		if ((format == ma_format_unknown) || (entry->channels == 0) || (entry->sampleRate == 0) ||
+			((ma_uint64)entry->offset + (ma_uint64)entry->frameCount * entry->channels * ma_get_bytes_per_sample(format) > header->dataSize) ||
+			((((ma_uint64)header->dataOffset + entry->offset) % ma_get_bytes_per_sample(format)) != 0))
+		{
+			DEBUG_WARNING_FMT(unityLogPtr, "SOUNDBANK: Sound bank entry %i is corrupted", (int)i);
+			RIQ_FREE(fileData);
+			return bank;
+		}
+
+		if (IsSoundBankEntryInDeviceFormat(entry)) keepFileData = true;
+		else convertedSize += ma_convert_frames(NULL, 0, AUDIO_DEVICE_FORMAT, AUDIO_DEVICE_CHANNELS, AUDIO.System.device.sampleRate, NULL, entry->frameCount, format, entry->channels, entry->sampleRate)*AUDIO_DEVICE_CHANNELS*ma_get_bytes_per_sample(AUDIO_DEVICE_FORMAT);
+	}
+
+	bank.soundCount = header->soundCount;
+	bank.entries = (SoundBankEntry*)RIQ_MALLOC(bank.soundCount * sizeof(SoundBankEntry));
+	bank.sounds = (Sound*)RIQ_CALLOC(bank.soundCount, sizeof(Sound));
+	bank.sampleData = (convertedSize > 0) ? RIQ_CALLOC((size_t)convertedSize, 1) : NULL;
+
+	if ((bank.entries == NULL) || (bank.sounds == NULL) || ((convertedSize > 0) && (bank.sampleData == NULL)))
+	{
+		DEBUG_WARNING(unityLogPtr, "SOUNDBANK: Failed to allocate memory for sound bank");
+		RIQ_FREE(bank.entries);
+		RIQ_FREE(bank.sounds);
+		RIQ_FREE(bank.sampleData);
+		RIQ_FREE(fileData);
+		return SoundBank{ 0 };
+	}
+
+	memcpy(bank.entries, entries, bank.soundCount * sizeof(SoundBankEntry));
+
+	// Every sound is a slice, either of the converted sample block or of the file data itself
+	unsigned char* converted = (unsigned char*)bank.sampleData;
+
+	for (unsigned int i = 0; i < bank.soundCount; i++)
+	{
+		SoundBankEntry* entry = &bank.entries[i];
+		entry->name[SOUND_BANK_NAME_LENGTH - 1] = '\0';
+
+		ma_format format = GetSoundBankEntryFormat(entry);
+		unsigned char* slice = fileData + header->dataOffset + entry->offset;
+
+		AudioBuffer* audioBuffer = LoadAudioBuffer(AUDIO_DEVICE_FORMAT, AUDIO_DEVICE_CHANNELS, AUDIO.System.device.sampleRate, 0, AUDIO_BUFFER_USAGE_STATIC);
+		if (audioBuffer == NULL)
+		{
+			DEBUG_WARNING_FMT(unityLogPtr, "SOUNDBANK: Failed to create buffer for [%s]", entry->name);
+			continue;
+		}
+
+		ma_uint32 frameCount = entry->frameCount;
+
+		if (IsSoundBankEntryInDeviceFormat(entry)) audioBuffer->data = slice;
+		else
+		{
+			frameCount = (ma_uint32)ma_convert_frames(NULL, 0, AUDIO_DEVICE_FORMAT, AUDIO_DEVICE_CHANNELS, AUDIO.System.device.sampleRate, NULL, entry->frameCount, format, entry->channels, entry->sampleRate);
+			frameCount = (ma_uint32)ma_convert_frames(converted, frameCount, AUDIO_DEVICE_FORMAT, AUDIO_DEVICE_CHANNELS, AUDIO.System.device.sampleRate, slice, entry->frameCount, format, entry->channels, entry->sampleRate);
+
+			audioBuffer->data = converted;
+			converted += (size_t)frameCount * AUDIO_DEVICE_CHANNELS * ma_get_bytes_per_sample(AUDIO_DEVICE_FORMAT);
+		}
+
+		audioBuffer->sizeInFrames = frameCount;
+		audioBuffer->sharedData = true;
+
+#if AUDIO_SILENCE_SKIP
+		audioBuffer->silence.threshold = powf(10.0f, AUDIO_SILENCE_THRESHOLD_DB / 20.0f);
+		audioBuffer->silence.spans = LoadSilenceSpans((const float*)audioBuffer->data, AUDIO_DEVICE_CHANNELS, frameCount, audioBuffer->silence.threshold, &audioBuffer->silence.spanCount);
+#endif
+
+		// Source data is the file slice itself, no copy
+		if (keepFileData)
+		{
+			audioBuffer->source.data = slice;
+			audioBuffer->source.format = format;
+			audioBuffer->source.channels = entry->channels;
+			audioBuffer->source.sampleRate = entry->sampleRate;
+			audioBuffer->source.frameCount = entry->frameCount;
+			audioBuffer->source.shared = true;
+		}
+
+		Sound* sound = &bank.sounds[i];
+		sound->frameCount = frameCount;
+		sound->stream.sampleRate = AUDIO.System.device.sampleRate;
+		sound->stream.sampleSize = 32;
+		sound->stream.channels = AUDIO_DEVICE_CHANNELS;
+		sound->stream.buffer = audioBuffer;
+	}
+
+	if (keepFileData) bank.fileData = fileData;
+	else RIQ_FREE(fileData);
+
+	DEBUG_LOG_FMT(unityLogPtr, "SOUNDBANK: Loaded %i sounds", (int)bank.soundCount);
+
+	return bank;
+}
+
+SoundBank RiqLoadSoundBank(const char* filePath)
+{
+	unsigned int dataSize = 0;
+	unsigned char* fileData = LoadFileData(filePath, &dataSize);
+
+	if (fileData == NULL) return SoundBank{ 0 };
+
+	return LoadSoundBankFromData(fileData, dataSize);
+}
+
+void RiqUnloadSoundBank(SoundBank bank)
+{
+	if (bank.sounds != NULL)
+	{
+		for (unsigned int i = 0; i < bank.soundCount; i++) UnloadAudioBuffer(bank.sounds[i].stream.buffer);
+	}
+
+	// Sample blocks are released along with the buffers, once the audio thread is done with them
+	if (bank.sampleData != NULL) RetireAudioMemory(bank.sampleData, ReleaseMemory);
+	if (bank.fileData != NULL) RetireAudioMemory(bank.fileData, ReleaseMemory);
+	ReclaimRetiredAudioMemory(false);
+
+	RIQ_FREE(bank.sounds);
+	RIQ_FREE(bank.entries);
+}
+
+int RiqGetSoundBankIndex(SoundBank bank, const char* name)
+{
+	if (name == NULL) return -1;
+
+	for (unsigned int i = 0; i < bank.soundCount; i++)
+	{
+		if (strncmp(bank.entries[i].name, name, SOUND_BANK_NAME_LENGTH) == 0) return (int)i;
+	}
+
+	return -1;
+}
+
+Sound RiqGetSoundBankSound(SoundBank bank, const char* name)
+{
+	int index = RiqGetSoundBankIndex(bank, name);
+
+	if (index < 0)
+	{
+		DEBUG_WARNING_FMT(unityLogPtr, "SOUNDBANK: Sound [%s] not found", (name != NULL) ? name : "");
+		return Sound{ 0 };
+	}
+
+	return bank.sounds[index];
+}
+
+// Export waves into a sound bank file, samples are stored in their wave format
+bool RiqExportSoundBank(const Wave* waves, const char** names, int count, const char* fileName)
+{
+	if ((waves == NULL) || (names == NULL) || (count <= 0) || (fileName == NULL)) return false;
+
+	SoundBankEntry* entries = (SoundBankEntry*)RIQ_CALLOC(count, sizeof(SoundBankEntry));
+	if (entries == NULL) return false;
+
+	SoundBankHeader header = { 0 };
+	memcpy(header.magic, "RIQB", 4);
+	header.version = SOUND_BANK_VERSION;
+	header.soundCount = (unsigned int)count;
+	header.dataOffset = (unsigned int)((sizeof(SoundBankHeader) + count * sizeof(SoundBankEntry) + SOUND_BANK_DATA_ALIGNMENT - 1) & ~(SOUND_BANK_DATA_ALIGNMENT - 1));
+
+	// Every sound starts aligned in the data block
+	for (int i = 0; i < count; i++)
+	{
+		strncpy(entries[i].name, (names[i] != NULL) ? names[i] : "", SOUND_BANK_NAME_LENGTH - 1);
+		entries[i].offset = header.dataSize;
+		entries[i].frameCount = waves[i].frameCount;
+		entries[i].sampleRate = waves[i].sampleRate;
+		entries[i].channels = (unsigned short)waves[i].channels;
+		entries[i].sampleSize = (unsigned short)waves[i].sampleSize;
+
+		unsigned int size = waves[i].frameCount * waves[i].channels * (waves[i].sampleSize / 8);
+		header.dataSize += (size + SOUND_BANK_DATA_ALIGNMENT - 1) & ~(SOUND_BANK_DATA_ALIGNMENT - 1);
+	}
+
+	bool success = false;
+	FILE* file = fopen(fileName, "wb");
+
+	if (file != NULL)
+	{
+		const unsigned char padding[SOUND_BANK_DATA_ALIGNMENT] = { 0 };
+		size_t indexSize = sizeof(SoundBankHeader) + count * sizeof(SoundBankEntry);
+
+		success = (fwrite(&header, sizeof(SoundBankHeader), 1, file) == 1) && (fwrite(entries, sizeof(SoundBankEntry), count, file) == (size_t)count);
+		if (success) success = (fwrite(padding, 1, header.dataOffset - indexSize, file) == header.dataOffset - indexSize);
+
+		for (int i = 0; success && (i < count); i++)
+		{
+			unsigned int size = waves[i].frameCount * waves[i].channels * (waves[i].sampleSize / 8);
+			unsigned int padSize = ((size + SOUND_BANK_DATA_ALIGNMENT - 1) & ~(SOUND_BANK_DATA_ALIGNMENT - 1)) - size;
+
+			success = (fwrite(waves[i].data, 1, size, file) == size) && (fwrite(padding, 1, padSize, file) == padSize);
+		}
+
+		fclose(file);
+	}
+
+	if (success) DEBUG_LOG_FMT(unityLogPtr, "SOUNDBANK: [%s] Exported %i sounds", fileName, count);
+	else DEBUG_WARNING_FMT(unityLogPtr, "SOUNDBANK: [%s] Failed to export sound bank", fileName);
+
+	RIQ_FREE(entries);
+
+	return success;
+}
+
+// ================================================================================
+#pragma endregion
+// ================================================================================
+
+// ================================================================================
+#pragma region Processors
+// ================================================================================
+
+// Allocates a chain with room for count processors, entries live in the same allocation
+static AudioProcessorChain* AllocAudioProcessorChain(unsigned int count)
+{
+	AudioProcessorChain* chain = (AudioProcessorChain*)RIQ_MALLOC(sizeof(AudioProcessorChain) + count * sizeof(AudioProcessorEntry));
+
+	if (chain != NULL)
+	{
+		chain->count = count;
+		chain->entries = (AudioProcessorEntry*)(chain + 1);
+	}
+
+	return chain;
+}
+
+// Publishes a new chain, the previous one is retired until the audio thread can't be using it anymore
+// NOTE: Called under the game lock, attach/detach from different game threads would otherwise lose each other's entries
+static void SwapAudioProcessorChain(std::atomic<AudioProcessorChain*>* target, AudioProcessorChain* chain)
+{
+	AudioProcessorChain* oldChain = target->exchange(chain);
+
+	RetireAudioMemory(oldChain, ReleaseMemory);
+}
+
+static bool AttachAudioProcessor(std::atomic<AudioProcessorChain*>* target, AudioProcessorCallback process, void* context)
+{
+	if (process == NULL) return false;
+
+	bool result = false;
+
+	ma_spinlock_lock(&AUDIO.System.gameLock);
+	{
+		AudioProcessorChain* oldChain = target->load();
+		unsigned int oldCount = (oldChain != NULL) ? oldChain->count : 0;
+
+		AudioProcessorChain* chain = AllocAudioProcessorChain(oldCount + 1);
+		if (chain != NULL)
+		{
+			// New processors go to the end of the chain
+			if (oldCount > 0) memcpy(chain->entries, oldChain->entries, oldCount * sizeof(AudioProcessorEntry));
+			chain->entries[oldCount].process = process;
+			chain->entries[oldCount].context = context;
+
+			SwapAudioProcessorChain(target, chain);
+			result = true;
+		}
+	}
+	ma_spinlock_unlock(&AUDIO.System.gameLock);
+
+	if (!result)
+	{
+		DEBUG_WARNING(unityLogPtr, "PROCESSOR: Failed to allocate memory for processor chain");
+		return false;
+	}
+
+	ReclaimRetiredAudioMemory(false);
+
+	return true;
+}
+
+// Returns the number of entries removed
+static unsigned int DetachAudioProcessor(std::atomic<AudioProcessorChain*>* target, AudioProcessorCallback process, void* context)
+{
+	unsigned int removed = 0;
+	bool failed = false;
+
+	ma_spinlock_lock(&AUDIO.System.gameLock);
+	{
+		AudioProcessorChain* oldChain = target->load();
+		AudioProcessorChain* chain = (oldChain != NULL) ? AllocAudioProcessorChain(oldChain->count) : NULL;
+
+		if ((oldChain != NULL) && (chain == NULL)) failed = true;
+		else if (chain != NULL)
+		{
+			// Every matching entry is removed
+			unsigned int count = 0;
+			for (unsigned int i = 0; i < oldChain->count; i++)
+			{
+				const AudioProcessorEntry* entry = &oldChain->entries[i];
+				if ((entry->process != process) || (entry->context != context)) chain->entries[count++] = *entry;
+			}
+
+			removed = oldChain->count - count;
+			chain->count = count;
+
+			if ((removed == 0) || (count == 0))
+			{
+				RIQ_FREE(chain);
+				chain = NULL;
+			}
+
+			if (removed > 0) SwapAudioProcessorChain(target, chain);
+		}
+	}
+	ma_spinlock_unlock(&AUDIO.System.gameLock);
+
+	if (failed)
+	{
+		DEBUG_WARNING(unityLogPtr, "PROCESSOR: Failed to allocate memory for processor chain");
+		return 0;
+	}
+
+	// A callback already running could still be calling into the old chain, once it is done the removed
+	// processors and their contexts are never touched again and the caller is free to release them
+	if (removed > 0)
+	{
+		WaitForAudioCallbackGrace();
+		ReclaimRetiredAudioMemory(false);
+	}
+
+	return removed;
+}
+
+// Runs a chain over a block of frames in mixing format, audio thread only
+// NOTE: Sound chains see the sound data channels, the mixed chain sees the output layout channels
+static void ProcessAudioProcessorChain(const AudioProcessorChain* chain, float* frames, ma_uint32 frameCount, ma_uint32 channels)
+{
+	const ma_uint32 sampleRate = AUDIO.System.device.sampleRate;
+
+	for (unsigned int i = 0; i < chain->count; i++)
+	{
+		chain->entries[i].process(chain->entries[i].context, frames, frameCount, channels, sampleRate);
+	}
+}
+
+bool RiqAttachSoundProcessor(Sound sound, AudioProcessorCallback process, void* context)
+{
+	if (sound.stream.buffer == NULL) return false;
+
+	return AttachAudioProcessor(&sound.stream.buffer->processorChain, process, context);
+}
+
+void RiqDetachSoundProcessor(Sound sound, AudioProcessorCallback process, void* context)
+{
+	if (sound.stream.buffer != NULL) DetachAudioProcessor(&sound.stream.buffer->processorChain, process, context);
+}
+
+bool RiqAttachMixedProcessor(AudioProcessorCallback process, void* context)
+{
+	return AttachAudioProcessor(&AUDIO.mixedProcessorChain, process, context);
+}
+
+void RiqDetachMixedProcessor(AudioProcessorCallback process, void* context)
+{
+	DetachAudioProcessor(&AUDIO.mixedProcessorChain, process, context);
+}
+
+// ================================================================================
+#pragma endregion
+// ================================================================================
+
+// ================================================================================
+#pragma region Effects
+// ================================================================================
+
+typedef struct BiquadStage
+{
+	int type;                                   // Filter type: BiquadType
+	float frequency;                            // Center/cutoff frequency in Hz
+	float q;                                    // Quality factor
+	float gainDb;                               // Gain in dB (peak and shelf types)
+
+	float b0, b1, b2, a1, a2;                   // Normalized coefficients, audio thread only
+	float z1[AUDIO_EFFECT_MAX_CHANNELS];        // Transposed direct form II state, audio thread only
+	float z2[AUDIO_EFFECT_MAX_CHANNELS];
+} BiquadStage;
+
+typedef struct EffectEQ
+{
+	int stageCount;
+	BiquadStage* stages;
+} EffectEQ;
+
+typedef struct EffectLimiter
+{
+	float threshold;                            // Linear threshold
+	float releaseMs;                            // Release time in milliseconds
+	unsigned int lookahead;                     // Lookahead in frames, fixed at creation
+
+	// Audio thread only
+	unsigned int channels;                      // Channels held by the delay line, it restarts empty when they change
+	float releaseCoef;
+	float envelope;
+	double boxSum;
+	ma_uint64 frameIndex;
+	unsigned int position;                      // Shared position on delay and box rings
+	unsigned int minHead, minCount;             // Monotonic deque for the sliding window minimum
+	float* delay;                               // lookahead * AUDIO_EFFECT_MAX_CHANNELS
+	float* box;                                 // lookahead
+	float* minValues;                           // lookahead + 1
+	ma_uint64* minIndices;                      // lookahead + 1
+} EffectLimiter;
+
+// Freeverb tunings, at 44100 Hz, second reverb lane is spread for stereo width
+static const int reverbCombTuning[4] = { 1116, 1188, 1277, 1356 };
+static const int reverbAllpassTuning[2] = { 556, 441 };
+#define REVERB_STEREO_SPREAD 23
+
+typedef struct EffectReverb
+{
+	float roomSize;                             // 0.0f to 1.0f
+	float damping;                              // 0.0f to 1.0f
+	float wet;                                  // 0.0f to 1.0f, dry level is 1.0f - wet
+
+	unsigned int capacityScale;                 // Lines are allocated for up to capacityScale * tuning samples
+
+	// Audio thread only, two lanes (left/right tunings) of 4 combs and 2 allpasses
+	float* combLines[2][4];
+	unsigned int combLength[2][4];
+	unsigned int combPos[2][4];
+	float combStore[2][4];
+	float* allpassLines[2][2];
+	unsigned int allpassLength[2][2];
+	unsigned int allpassPos[2][2];
+} EffectReverb;
+
+// Where an effect is attached, filter state is per effect so it can only run on one chain
+typedef enum
+{
+	AUDIO_EFFECT_DETACHED = 0,
+	AUDIO_EFFECT_ON_SOUND,
+	AUDIO_EFFECT_ON_MIX,
+	AUDIO_EFFECT_UNLOADING
+} AudioEffectAttachment;
+
+struct AudioEffect
+{
+	int type;                                   // Effect type: AudioEffectType
+	AudioProcessorCallback process;             // Processor registered in chains
+
+	std::atomic<int> attachment;                // AudioEffectAttachment, claimed before the chain is published
+	std::atomic<unsigned int> version;          // Incremented by the game thread on parameter changes
+	unsigned int appliedVersion;                // Parameters version in use, audio thread only
+	unsigned int appliedSampleRate;             // Sample rate coefficients are computed for, audio thread only
+
+	union
+	{
+		EffectEQ eq;
+		EffectLimiter limiter;
+		EffectReverb reverb;
+	};
+};
+
+// Computes biquad coefficients, RBJ audio EQ cookbook formulas
+static void ComputeBiquadCoefficients(BiquadStage* stage, ma_uint32 sampleRate)
+{
+	float frequency = stage->frequency;
+	if (frequency > 0.49f * sampleRate) frequency = 0.49f * sampleRate;
+	if (frequency < 1.0f) frequency = 1.0f;
+
+	const float q = (stage->q > 0.01f) ? stage->q : 0.01f;
+	const float w0 = 2.0f * (float)MA_PI * frequency / (float)sampleRate;
+	const float cosW0 = cosf(w0);
+	const float alpha = sinf(w0) / (2.0f * q);
+	const float A = powf(10.0f, stage->gainDb / 40.0f);
+
+	float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f, a0 = 1.0f, a1 = 0.0f, a2 = 0.0f;
+
+	switch (stage->type)
+	{
+		case BIQUAD_LOWPASS:
+		{
+			b0 = (1.0f - cosW0) * 0.5f; b1 = 1.0f - cosW0; b2 = b0;
+			a0 = 1.0f + alpha; a1 = -2.0f * cosW0; a2 = 1.0f - alpha;
+		} break;
+		case BIQUAD_HIGHPASS:
+		{
+			b0 = (1.0f + cosW0) * 0.5f; b1 = -(1.0f + cosW0); b2 = b0;
+			a0 = 1.0f + alpha; a1 = -2.0f * cosW0; a2 = 1.0f - alpha;
+		} break;
+		case BIQUAD_BANDPASS:
+		{
+			b0 = alpha; b1 = 0.0f; b2 = -alpha;
+			a0 = 1.0f + alpha; a1 = -2.0f * cosW0; a2 = 1.0f - alpha;
+		} break;
+		case BIQUAD_NOTCH:
+		{
+			b0 = 1.0f; b1 = -2.0f * cosW0; b2 = 1.0f;
+			a0 = 1.0f + alpha; a1 = -2.0f * cosW0; a2 = 1.0f - alpha;
+		} break;
+		case BIQUAD_PEAK:
+		{
+			b0 = 1.0f + alpha * A; b1 = -2.0f * cosW0; b2 = 1.0f - alpha * A;
+			a0 = 1.0f + alpha / A; a1 = -2.0f * cosW0; a2 = 1.0f - alpha / A;
+		} break;
+		case BIQUAD_LOWSHELF:
+		{
+			const float sqrtA2Alpha = 2.0f * sqrtf(A) * alpha;
+			b0 = A * ((A + 1.0f) - (A - 1.0f) * cosW0 + sqrtA2Alpha);
+			b1 = 2.0f * A * ((A - 1.0f) - (A + 1.0f) * cosW0);
+			b2 = A * ((A + 1.0f) - (A - 1.0f) * cosW0 - sqrtA2Alpha);
+			a0 = (A + 1.0f) + (A - 1.0f) * cosW0 + sqrtA2Alpha;
+			a1 = -2.0f * ((A - 1.0f) + (A + 1.0f) * cosW0);
+			a2 = (A + 1.0f) + (A - 1.0f) * cosW0 - sqrtA2Alpha;
+		} break;
+		case BIQUAD_HIGHSHELF:
+		{
+			const float sqrtA2Alpha = 2.0f * sqrtf(A) * alpha;
+			b0 = A * ((A + 1.0f) + (A - 1.0f) * cosW0 + sqrtA2Alpha);
+			b1 = -2.0f * A * ((A - 1.0f) + (A + 1.0f) * cosW0);
+			b2 = A * ((A + 1.0f) + (A - 1.0f) * cosW0 - sqrtA2Alpha);
+			a0 = (A + 1.0f) - (A - 1.0f) * cosW0 + sqrtA2Alpha;
+			a1 = 2.0f * ((A - 1.0f) - (A + 1.0f) * cosW0);
+			a2 = (A + 1.0f) - (A - 1.0f) * cosW0 - sqrtA2Alpha;
+		} break;
+		default: break;
+	}
+
+	stage->b0 = b0 / a0;
+	stage->b1 = b1 / a0;
+	stage->b2 = b2 / a0;
+	stage->a1 = a1 / a0;
+	stage->a2 = a2 / a0;
+}
+
+// Runs one biquad stage over a block, channels are processed side by side in SIMD lanes
+static void ProcessBiquadStage(BiquadStage* stage, float* frames, ma_uint32 frameCount, ma_uint32 channels)
+{
+	ma_uint32 c = 0;
+
+#if defined(RIQ_SIMD_SSE2)
+	const __m128 b0 = _mm_set1_ps(stage->b0);
+	const __m128 b1 = _mm_set1_ps(stage->b1);
+	const __m128 b2 = _mm_set1_ps(stage->b2);
+	const __m128 a1 = _mm_set1_ps(stage->a1);
+	const __m128 a2 = _mm_set1_ps(stage->a2);
+
+	// Groups of 4 channels (quad, 5.1 front, 7.1)
+	for (; c + 4 <= channels; c += 4)
+	{
+		__m128 z1 = _mm_loadu_ps(stage->z1 + c);
+		__m128 z2 = _mm_loadu_ps(stage->z2 + c);
+
+		for (ma_uint32 frame = 0; frame < frameCount; frame++)
+		{
+			float* p = frames + (frame * channels) + c;
+			__m128 x = _mm_loadu_ps(p);
+			__m128 y = _mm_add_ps(_mm_mul_ps(b0, x), z1);
+			z1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1, x), _mm_mul_ps(a1, y)), z2);
+			z2 = _mm_sub_ps(_mm_mul_ps(b2, x), _mm_mul_ps(a2, y));
+			_mm_storeu_ps(p, y);
+		}
+
+		_mm_storeu_ps(stage->z1 + c, z1);
+		_mm_storeu_ps(stage->z2 + c, z2);
+	}
+
+	// Pair of channels (stereo) in the two low lanes
+	for (; c + 2 <= channels; c += 2)
+	{
+		__m128 z1 = _mm_castpd_ps(_mm_load_sd((const double*)(stage->z1 + c)));
+		__m128 z2 = _mm_castpd_ps(_mm_load_sd((const double*)(stage->z2 + c)));
+
+		for (ma_uint32 frame = 0; frame < frameCount; frame++)
+		{
+			float* p = frames + (frame * channels) + c;
+			__m128 x = _mm_castpd_ps(_mm_load_sd((const double*)p));
+			__m128 y = _mm_add_ps(_mm_mul_ps(b0, x), z1);
+			z1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1, x), _mm_mul_ps(a1, y)), z2);
+			z2 = _mm_sub_ps(_mm_mul_ps(b2, x), _mm_mul_ps(a2, y));
+			_mm_store_sd((double*)p, _mm_castps_pd(y));
+		}
+
+		_mm_store_sd((double*)(stage->z1 + c), _mm_castps_pd(z1));
+		_mm_store_sd((double*)(stage->z2 + c), _mm_castps_pd(z2));
+	}
+#endif
+
+	// Remaining channels
+	for (; c < channels; c++)
+	{
+		float z1 = stage->z1[c];
+		float z2 = stage->z2[c];
+
+		for (ma_uint32 frame = 0; frame < frameCount; frame++)
+		{
+			float* p = frames + (frame * channels) + c;
+			float x = *p;
+			float y = stage->b0 * x + z1;
+			z1 = stage->b1 * x - stage->a1 * y + z2;
+			z2 = stage->b2 * x - stage->a2 * y;
+			*p = y;
+		}
+
+		stage->z1[c] = z1;
+		stage->z2[c] = z2;
+	}
+}
+
+static void ProcessEffectEQ(void* context, float* frames, unsigned int frameCount, unsigned int channels, unsigned int sampleRate)
+{
+	AudioEffect* effect = (AudioEffect*)context;
+	EffectEQ* eq = &effect->eq;
+
+	unsigned int version = effect->version.load(std::memory_order_acquire);
+	if ((version != effect->appliedVersion) || (sampleRate != effect->appliedSampleRate))
+	{
+		for (int i = 0; i < eq->stageCount; i++) ComputeBiquadCoefficients(&eq->stages[i], sampleRate);
+
+		effect->appliedVersion = version;
+		effect->appliedSampleRate = sampleRate;
+	}
+
+	// Channels over the supported count are left dry
+	if (channels > AUDIO_EFFECT_MAX_CHANNELS) channels = AUDIO_EFFECT_MAX_CHANNELS;
+
+	// NOTE: Stages are processed one after another over the whole block, this keeps the block hot in cache
+	// while every stage state stays in registers
+	for (int i = 0; i < eq->stageCount; i++) ProcessBiquadStage(&eq->stages[i], frames, frameCount, channels);
+}
+
+static void ProcessEffectLimiter(void* context, float* frames, unsigned int frameCount, unsigned int channels, unsigned int sampleRate)
+{
+	AudioEffect* effect = (AudioEffect*)context;
+	EffectLimiter* limiter = &effect->limiter;
+
+	unsigned int version = effect->version.load(std::memory_order_acquire);
+	if ((version != effect->appliedVersion) || (sampleRate != effect->appliedSampleRate))
+	{
+		limiter->releaseCoef = 1.0f - expf(-1.0f / (limiter->releaseMs * 0.001f * (float)sampleRate));
+
+		effect->appliedVersion = version;
+		effect->appliedSampleRate = sampleRate;
+	}
+
+	const unsigned int lookahead = limiter->lookahead;
+	const unsigned int stride = channels;
+
+	// Channels over the supported count are left dry, the delay line is sized for all supported layouts
+	// and restarts empty when the chain layout changes, instead of playing frames of the previous one
+	if (channels > AUDIO_EFFECT_MAX_CHANNELS) channels = AUDIO_EFFECT_MAX_CHANNELS;
+	if (channels != limiter->channels)
+	{
+		memset(limiter->delay, 0, (size_t)lookahead * AUDIO_EFFECT_MAX_CHANNELS * sizeof(float));
+		limiter->channels = channels;
+	}
+
+	const unsigned int window = lookahead + 1;
+	const float threshold = limiter->threshold;
+	const float releaseCoef = limiter->releaseCoef;
+
+	// The minimum target gain over the last lookahead + 1 frames is smoothed with a box filter of lookahead frames,
+	// every envelope value in the box covers the frame leaving the delay line, so the gain never exceeds its target
+	for (unsigned int frame = 0; frame < frameCount; frame++)
+	{
+		float* frameIO = frames + (frame * stride);
+
+		float peak = 0.0f;
+		for (unsigned int c = 0; c < channels; c++)
+		{
+			float v = fabsf(frameIO[c]);
+			if (v > peak) peak = v;
+		}
+
+		float target = (peak > threshold) ? (threshold / peak) : 1.0f;
+
+		// Monotonic deque, front holds the window minimum, expired values leave before the new one gets in
+		if ((limiter->minCount > 0) && (limiter->minIndices[limiter->minHead] + window <= limiter->frameIndex))
+		{
+			limiter->minHead = (limiter->minHead + 1) % window;
+			limiter->minCount--;
+		}
+
+		while (limiter->minCount > 0)
+		{
+			unsigned int back = (limiter->minHead + limiter->minCount - 1) % window;
+			if (limiter->minValues[back] < target) break;
+			limiter->minCount--;
+		}
+
+		unsigned int tail = (limiter->minHead + limiter->minCount) % window;
+		limiter->minValues[tail] = target;
+		limiter->minIndices[tail] = limiter->frameIndex;
+		limiter->minCount++;
+
+		float windowMin = limiter->minValues[limiter->minHead];
+
+		// Instant attack, exponential release
+		if (windowMin < limiter->envelope) limiter->envelope = windowMin;
+		else limiter->envelope += (windowMin - limiter->envelope) * releaseCoef;
+
+		unsigned int position = limiter->position;
+		limiter->boxSum += (double)limiter->envelope - (double)limiter->box[position];
+		limiter->box[position] = limiter->envelope;
+
+		float gain = (float)(limiter->boxSum / (double)lookahead);
+
+		// Oldest frame in the delay line goes out, current frame goes in
+		float* delayed = limiter->delay + ((size_t)position * channels);
+		for (unsigned int c = 0; c < channels; c++)
+		{
+			float v = delayed[c];
+			delayed[c] = frameIO[c];
+			frameIO[c] = v * gain;
+		}
+
+		limiter->position = (position + 1 == lookahead) ? 0 : position + 1;
+		limiter->frameIndex++;
+	}
+}
+
+// Resets reverb lines to the lengths for a sample rate
+static void ResetEffectReverb(EffectReverb* reverb, ma_uint32 sampleRate)
+{
+	const float scale = (float)sampleRate / 44100.0f;
+
+	for (int lane = 0; lane < 2; lane++)
+	{
+		int spread = lane * REVERB_STEREO_SPREAD;
+
+		for (int i = 0; i < 4; i++)
+		{
+			unsigned int capacity = reverb->capacityScale * (reverbCombTuning[i] + REVERB_STEREO_SPREAD);
+			unsigned int length = (unsigned int)((reverbCombTuning[i] + spread) * scale);
+			if (length > capacity) length = capacity;
+			if (length == 0) length = 1;
+
+			reverb->combLength[lane][i] = length;
+			reverb->combPos[lane][i] = 0;
+			reverb->combStore[lane][i] = 0.0f;
+			memset(reverb->combLines[lane][i], 0, capacity * sizeof(float));
+		}
+
+		for (int i = 0; i < 2; i++)
+		{
+			unsigned int capacity = reverb->capacityScale * (reverbAllpassTuning[i] + REVERB_STEREO_SPREAD);
+			unsigned int length = (unsigned int)((reverbAllpassTuning[i] + spread) * scale);
+			if (length > capacity) length = capacity;
+			if (length == 0) length = 1;
+
+			reverb->allpassLength[lane][i] = length;
+			reverb->allpassPos[lane][i] = 0;
+			memset(reverb->allpassLines[lane][i], 0, capacity * sizeof(float));
+		}
+	}
+}
+
+static void ProcessEffectReverb(void* context, float* frames, unsigned int frameCount, unsigned int channels, unsigned int sampleRate)
+{
+	AudioEffect* effect = (AudioEffect*)context;
+	EffectReverb* reverb = &effect->reverb;
+
+	if (sampleRate != effect->appliedSampleRate)
+	{
+		ResetEffectReverb(reverb, sampleRate);
+		effect->appliedSampleRate = sampleRate;
+	}
+
+	effect->appliedVersion = effect->version.load(std::memory_order_acquire);
+
+	// Freeverb scaling
+	const float feedback = reverb->roomSize * 0.28f + 0.7f;
+	const float damp1 = reverb->damping * 0.4f;
+	const float damp2 = 1.0f - damp1;
+	const float wet = reverb->wet * 3.0f;
+	const float dry = 1.0f - reverb->wet;
+	const float inputGain = 0.015f / (float)channels;
+
+	for (unsigned int frame = 0; frame < frameCount; frame++)
+	{
+		float* frameIO = frames + (frame * channels);
+
+		float input = 0.0f;
+		for (unsigned int c = 0; c < channels; c++) input += frameIO[c];
+		input *= inputGain;
+
+		float laneOut[2];
+
+		for (int lane = 0; lane < 2; lane++)
+		{
+			float** lines = reverb->combLines[lane];
+			unsigned int* pos = reverb->combPos[lane];
+
+			float sum = 0.0f;
+
+#if defined(RIQ_SIMD_SSE2)
+			// The 4 parallel combs run side by side in SIMD lanes
+			__m128 out = _mm_setr_ps(lines[0][pos[0]], lines[1][pos[1]], lines[2][pos[2]], lines[3][pos[3]]);
+			__m128 store = _mm_loadu_ps(reverb->combStore[lane]);
+			store = _mm_add_ps(_mm_mul_ps(out, _mm_set1_ps(damp2)), _mm_mul_ps(store, _mm_set1_ps(damp1)));
+			__m128 next = _mm_add_ps(_mm_set1_ps(input), _mm_mul_ps(store, _mm_set1_ps(feedback)));
+			_mm_storeu_ps(reverb->combStore[lane], store);
+
+			float outs[4], nexts[4];
+			_mm_storeu_ps(outs, out);
+			_mm_storeu_ps(nexts, next);
+
+			for (int i = 0; i < 4; i++)
+			{
+				lines[i][pos[i]] = nexts[i];
+				sum += outs[i];
+			}
+#else
+			for (int i = 0; i < 4; i++)
+			{
+				float out = lines[i][pos[i]];
+				reverb->combStore[lane][i] = out * damp2 + reverb->combStore[lane][i] * damp1;
+				lines[i][pos[i]] = input + reverb->combStore[lane][i] * feedback;
+				sum += out;
+			}
+#endif
+			for (int i = 0; i < 4; i++) if (++pos[i] >= reverb->combLength[lane][i]) pos[i] = 0;
+
+			// Allpasses in series
+			for (int i = 0; i < 2; i++)
+			{
+				float* line = reverb->allpassLines[lane][i];
+				unsigned int* p = &reverb->allpassPos[lane][i];
+
+				float buffered = line[*p];
+				line[*p] = sum + buffered * 0.5f;
+				sum = buffered - sum;
+
+				if (++(*p) >= reverb->allpassLength[lane][i]) *p = 0;
+			}
+
+			laneOut[lane] = sum;
+		}
+
+		for (unsigned int c = 0; c < channels; c++) frameIO[c] = frameIO[c] * dry + laneOut[c % 2] * wet;
+	}
+}
+
+static AudioEffect* AllocAudioEffect(int type, AudioProcessorCallback process)
+{
+	AudioEffect* effect = (AudioEffect*)RIQ_CALLOC(1, sizeof(AudioEffect));
+
+	if (effect != NULL)
+	{
+		effect->type = type;
+		effect->process = process;
+		effect->attachment = AUDIO_EFFECT_DETACHED;
+		effect->version = 1;
+		effect->appliedVersion = 0;
+		effect->appliedSampleRate = 0;
+	}
+	else DEBUG_WARNING(unityLogPtr, "EFFECT: Failed to allocate memory for effect");
+
+	return effect;
+}
+
+AudioEffect* RiqLoadEffectEQ(int stageCount)
+{
+	if (stageCount <= 0) return NULL;
+
+	AudioEffect* effect = AllocAudioEffect(AUDIO_EFFECT_EQ, ProcessEffectEQ);
+	if (effect == NULL) return NULL;
+
+	effect->eq.stageCount = stageCount;
+	effect->eq.stages = (BiquadStage*)RIQ_CALLOC(stageCount, sizeof(BiquadStage));
+
+	if (effect->eq.stages == NULL)
+	{
+		DEBUG_WARNING(unityLogPtr, "EFFECT: Failed to allocate memory for EQ stages");
+		RIQ_FREE(effect);
+		return NULL;
+	}
+
+	// Every stage starts as a flat peak filter
+	for (int i = 0; i < stageCount; i++)
+	{
+		effect->eq.stages[i].type = BIQUAD_PEAK;
+		effect->eq.stages[i].frequency = 1000.0f;
+		effect->eq.stages[i].q = 0.7071f;
+		effect->eq.stages[i].gainDb = 0.0f;
+	}
+
+	return effect;
+}
+
+void RiqSetEffectEQStage(AudioEffect* effect, int stage, int type, float frequency, float q, float gainDb)
+{
+	if ((effect == NULL) || (effect->type != AUDIO_EFFECT_EQ)) return;
+	if ((stage < 0) || (stage >= effect->eq.stageCount)) return;
+
+	// Parameters are read by the audio thread every block, they change while the mixer is out
+	const bool locked = AUDIO.System.isReady;
+	if (locked) ma_mutex_lock(&AUDIO.System.lock);
+	{
+		BiquadStage* biquad = &effect->eq.stages[stage];
+		biquad->type = type;
+		biquad->frequency = frequency;
+		biquad->q = q;
+		biquad->gainDb = gainDb;
+
+		// Audio thread recomputes coefficients on its next block
+		effect->version.fetch_add(1, std::memory_order_release);
+	}
+	if (locked) ma_mutex_unlock(&AUDIO.System.lock);
+}
+
+AudioEffect* RiqLoadEffectLowPass(float cutoff)
+{
+	AudioEffect* effect = RiqLoadEffectEQ(1);
+
+	if (effect != NULL) RiqSetEffectEQStage(effect, 0, BIQUAD_LOWPASS, cutoff, 0.7071f, 0.0f);
+
+	return effect;
+}
+
+AudioEffect* RiqLoadEffectLimiter(float thresholdDb, float lookaheadMs, float releaseMs)
+{
+	AudioEffect* effect = AllocAudioEffect(AUDIO_EFFECT_LIMITER, ProcessEffectLimiter);
+	if (effect == NULL) return NULL;
+
+	EffectLimiter* limiter = &effect->limiter;
+
+	// Lookahead length is fixed at creation, computed for the current device sample rate
+	ma_uint32 sampleRate = (AUDIO.System.device.sampleRate > 0) ? AUDIO.System.device.sampleRate : 48000;
+
+	limiter->lookahead = (unsigned int)(lookaheadMs * 0.001f * (float)sampleRate);
+	if (limiter->lookahead < 1) limiter->lookahead = 1;
+
+	limiter->threshold = powf(10.0f, thresholdDb / 20.0f);
+	limiter->releaseMs = (releaseMs > 1.0f) ? releaseMs : 1.0f;
+
+	// Sound chains are stereo and the mixed chain follows the output layout, the delay line fits any of them
+	limiter->delay = (float*)RIQ_CALLOC((size_t)limiter->lookahead * AUDIO_EFFECT_MAX_CHANNELS, sizeof(float));
+	limiter->box = (float*)RIQ_MALLOC(limiter->lookahead * sizeof(float));
+	limiter->minValues = (float*)RIQ_MALLOC((limiter->lookahead + 1) * sizeof(float));
+	limiter->minIndices = (ma_uint64*)RIQ_MALLOC((limiter->lookahead + 1) * sizeof(ma_uint64));
+
+	if ((limiter->delay == NULL) || (limiter->box == NULL) || (limiter->minValues == NULL) || (limiter->minIndices == NULL))
+	{
+		DEBUG_WARNING(unityLogPtr, "EFFECT: Failed to allocate memory for limiter");
+		RiqUnloadEffect(effect);
+		return NULL;
+	}
+
+	// Gain starts at unity
+	for (unsigned int i = 0; i < limiter->lookahead; i++) limiter->box[i] = 1.0f;
+	limiter->boxSum = (double)limiter->lookahead;
+	limiter->envelope = 1.0f;
+
+	return effect;
+}
+
+AudioEffect* RiqLoadEffectReverb(float roomSize, float damping, float wet)
+{
+	AudioEffect* effect = AllocAudioEffect(AUDIO_EFFECT_REVERB, ProcessEffectReverb);
+	if (effect == NULL) return NULL;
+
+	EffectReverb* reverb = &effect->reverb;
+
+	// Lines are sized for the device sample rate, with room for 48 kHz at least
+	ma_uint32 sampleRate = (AUDIO.System.device.sampleRate > 48000) ? AUDIO.System.device.sampleRate : 48000;
+	reverb->capacityScale = (sampleRate + 44099) / 44100;
+
+	bool success = true;
+	for (int lane = 0; lane < 2; lane++)
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			reverb->combLines[lane][i] = (float*)RIQ_CALLOC(reverb->capacityScale * (reverbCombTuning[i] + REVERB_STEREO_SPREAD), sizeof(float));
+			if (reverb->combLines[lane][i] == NULL) success = false;
+		}
+
+		for (int i = 0; i < 2; i++)
+		{
+			reverb->allpassLines[lane][i] = (float*)RIQ_CALLOC(reverb->capacityScale * (reverbAllpassTuning[i] + REVERB_STEREO_SPREAD), sizeof(float));
+			if (reverb->allpassLines[lane][i] == NULL) success = false;
+		}
+	}
+
+	if (!success)
+	{
+		DEBUG_WARNING(unityLogPtr, "EFFECT: Failed to allocate memory for reverb");
+		RiqUnloadEffect(effect);
+		return NULL;
+	}
+
+	RiqSetEffectReverb(effect, roomSize, damping, wet);
+
+	return effect;
+}
+
+void RiqSetEffectReverb(AudioEffect* effect, float roomSize, float damping, float wet)
+{
+	if ((effect == NULL) || (effect->type != AUDIO_EFFECT_REVERB)) return;
+
+	const bool locked = AUDIO.System.isReady;
+	if (locked) ma_mutex_lock(&AUDIO.System.lock);
+	{
+		effect->reverb.roomSize = (roomSize < 0.0f) ? 0.0f : ((roomSize > 1.0f) ? 1.0f : roomSize);
+		effect->reverb.damping = (damping < 0.0f) ? 0.0f : ((damping > 1.0f) ? 1.0f : damping);
+		effect->reverb.wet = (wet < 0.0f) ? 0.0f : ((wet > 1.0f) ? 1.0f : wet);
+
+		effect->version.fetch_add(1, std::memory_order_release);
+	}
+	if (locked) ma_mutex_unlock(&AUDIO.System.lock);
+}
+
+void RiqSetEffectLimiter(AudioEffect* effect, float thresholdDb, float releaseMs)
+{
+	if ((effect == NULL) || (effect->type != AUDIO_EFFECT_LIMITER)) return;
+
+	const float threshold = powf(10.0f, thresholdDb / 20.0f);
+
+	const bool locked = AUDIO.System.isReady;
+	if (locked) ma_mutex_lock(&AUDIO.System.lock);
+	{
+		effect->limiter.threshold = threshold;
+		effect->limiter.releaseMs = (releaseMs > 1.0f) ? releaseMs : 1.0f;
+
+		effect->version.fetch_add(1, std::memory_order_release);
+	}
+	if (locked) ma_mutex_unlock(&AUDIO.System.lock);
+}
+
+static void ReleaseAudioEffect(void* ptr)
+{
+	AudioEffect* effect = (AudioEffect*)ptr;
+
+	switch (effect->type)
+	{
+		case AUDIO_EFFECT_EQ: RIQ_FREE(effect->eq.stages); break;
+		case AUDIO_EFFECT_LIMITER:
+		{
+			RIQ_FREE(effect->limiter.delay);
+			RIQ_FREE(effect->limiter.box);
+			RIQ_FREE(effect->limiter.minValues);
+			RIQ_FREE(effect->limiter.minIndices);
+		} break;
+		case AUDIO_EFFECT_REVERB:
+		{
+			for (int lane = 0; lane < 2; lane++)
+			{
+				for (int i = 0; i < 4; i++) RIQ_FREE(effect->reverb.combLines[lane][i]);
+				for (int i = 0; i < 2; i++) RIQ_FREE(effect->reverb.allpassLines[lane][i]);
+			}
+		} break;
+		default: break;
+	}
+
+	RIQ_FREE(effect);
+}
+
+// Drops the references a buffer chain holds on effects, called when the buffer is unloaded
+static void DetachAudioBufferEffects(AudioBuffer* buffer)
+{
+	const AudioProcessorChain* chain = buffer->processorChain.load();
+	if (chain == NULL) return;
+
+	for (unsigned int i = 0; i < chain->count; i++)
+	{
+		AudioProcessorCallback process = chain->entries[i].process;
+
+		if ((process == ProcessEffectEQ) || (process == ProcessEffectLimiter) || (process == ProcessEffectReverb))
+		{
+			((AudioEffect*)chain->entries[i].context)->attachment.store(AUDIO_EFFECT_DETACHED);
+		}
+	}
+}
+
+void RiqUnloadEffect(AudioEffect* effect)
+{
+	if (effect == NULL) return;
+
+	// Refused before anything is touched, sounds can't be enumerated safely from the game thread
+	if (effect->attachment.load() == AUDIO_EFFECT_ON_SOUND)
+	{
+		DEBUG_WARNING(unityLogPtr, "EFFECT: Effect is still attached to a sound, detach it before unloading");
+		return;
+	}
+
+	RiqDetachMixedEffect(effect);
+
+	// Claimed for unloading, attach calls racing this one fail from now on
+	int expected = AUDIO_EFFECT_DETACHED;
+	if (!effect->attachment.compare_exchange_strong(expected, AUDIO_EFFECT_UNLOADING))
+	{
+		DEBUG_WARNING(unityLogPtr, "EFFECT: Effect was attached while unloading, detach it before unloading");
+		return;
+	}
+
+	// A callback could still be running the chain the effect was detached from
+	RetireAudioMemory(effect, ReleaseAudioEffect);
+	ReclaimRetiredAudioMemory(false);
+}
+
+// Claims the effect for a chain before it is published, so an unload can never see it detached while attached
+static bool AttachAudioEffect(std::atomic<AudioProcessorChain*>* target, AudioEffect* effect, AudioEffectAttachment attachment)
+{
+	int expected = AUDIO_EFFECT_DETACHED;
+	if (!effect->attachment.compare_exchange_strong(expected, attachment))
+	{
+		// Filter state would run twice per callback and corrupt both signals
+		if (expected != AUDIO_EFFECT_UNLOADING) DEBUG_WARNING(unityLogPtr, "EFFECT: Effect is already attached, an effect runs on one chain at a time");
+		return false;
+	}
+
+	if (!AttachAudioProcessor(target, effect->process, effect))
+	{
+		effect->attachment.store(AUDIO_EFFECT_DETACHED);
+		return false;
+	}
+
+	return true;
+}
+
+bool RiqAttachSoundEffect(Sound sound, AudioEffect* effect)
+{
+	if ((effect == NULL) || (sound.stream.buffer == NULL)) return false;
+
+	return AttachAudioEffect(&sound.stream.buffer->processorChain, effect, AUDIO_EFFECT_ON_SOUND);
+}
+
+void RiqDetachSoundEffect(Sound sound, AudioEffect* effect)
+{
+	if ((effect == NULL) || (sound.stream.buffer == NULL)) return;
+
+	if (DetachAudioProcessor(&sound.stream.buffer->processorChain, effect->process, effect) > 0) effect->attachment.store(AUDIO_EFFECT_DETACHED);
+}
+
+bool RiqAttachMixedEffect(AudioEffect* effect)
+{
+	if (effect == NULL) return false;
+
+	return AttachAudioEffect(&AUDIO.mixedProcessorChain, effect, AUDIO_EFFECT_ON_MIX);
+}
+
+void RiqDetachMixedEffect(AudioEffect* effect)
+{
+	if (effect == NULL) return;
+
+	if (DetachAudioProcessor(&AUDIO.mixedProcessorChain, effect->process, effect) > 0) effect->attachment.store(AUDIO_EFFECT_DETACHED);
+}
+
+// ================================================================================
+#pragma endregion
+// ================================================================================
+
+// ================================================================================
+#pragma region Commands
+// ================================================================================
+
+AudioCommandBuffer* RiqGetCommandBuffer(void)
+{
+	return &AUDIO.commandBuffer;
+}
+
+void RiqSubmitCommands(void)
+{
+	AudioCommandBuffer* commandBuffer = &AUDIO.commandBuffer;
+
+	unsigned int count = commandBuffer->count;
+	if (count > commandBuffer->capacity) count = commandBuffer->capacity;
+	if (count == 0) return;
+
+	LoadAudioBufferTimeStretches(commandBuffer->commands, count);
+
+	// All queued commands are applied under a single lock, so they land on the same mixing callback
+	const bool locked = AUDIO.System.isReady;
+	if (locked) ma_mutex_lock(&AUDIO.System.lock);
+	{
+		for (unsigned int i = 0; i < count; i++)
+		{
+			const AudioCommand* command = &commandBuffer->commands[i];
+
+			AudioBuffer* buffer = GetAudioBufferFromHandle(command->handle);
+			if (buffer == NULL) continue;
+
+			switch (command->type)
+			{
+				case AUDIO_COMMAND_PLAY: PlayAudioBuffer(buffer); break;
+				case AUDIO_COMMAND_STOP: StopAudioBuffer(buffer); break;
+				case AUDIO_COMMAND_PAUSE: PauseAudioBuffer(buffer); break;
+				case AUDIO_COMMAND_RESUME: ResumeAudioBuffer(buffer); break;
+				case AUDIO_COMMAND_SET_VOLUME: SetAudioBufferVolume(buffer, command->value); break;
+				case AUDIO_COMMAND_SET_PITCH: SetAudioBufferPitch(buffer, command->value); break;
+				case AUDIO_COMMAND_SET_PAN: SetAudioBufferPan(buffer, command->value); break;
+				case AUDIO_COMMAND_SET_TEMPO: SetAudioBufferTempo(buffer, command->value); break;
+				case AUDIO_COMMAND_SET_RESAMPLER: SetAudioBufferResampler(buffer, (int)command->value); break;
+				default: break;
+			}
+		}
+	}
+	if (locked) ma_mutex_unlock(&AUDIO.System.lock);
+
+	// Once per frame is a good pace to release memory retired by unloads and processor changes
+	ReclaimRetiredAudioMemory(false);
+
+	if (commandBuffer->count > commandBuffer->capacity) DEBUG_WARNING_FMT(unityLogPtr, "COMMANDS: Command buffer overflow, %i commands dropped", commandBuffer->count - commandBuffer->capacity);
+
+	commandBuffer->count = 0;
+}
+
+// ================================================================================
+#pragma endregion
+// ================================================================================
+
+// ================================================================================
+#pragma region Latency Calibration
+// ================================================================================
+
+AudioCalibrationOptions RiqGetDefaultAudioCalibrationOptions(void)
+{
+	AudioCalibrationOptions options = { 0 };
+
+	options.clickCount = 8;
+	options.clickIntervalMs = 150;
+	options.maxLatencyMs = 500;
+	options.syntheticLoopbackFrames = 0;
+
+	return options;
+}
+
+// Builds the click train reference, every click is the same short windowed noise burst
+// NOTE: Clicks are spaced unevenly so correlation can not lock on a neighbour click
+static void BuildCalibrationClickTrain(float* reference, ma_uint32 frameCount, ma_uint32* clickFrames, ma_uint32 clickCount, ma_uint32 interval)
+{
+	float burst[AUDIO_CALIBRATION_CLICK_FRAMES] = { 0 };
+	ma_uint32 seed = 0x52495142;
+
+	for (int i = 0; i < AUDIO_CALIBRATION_CLICK_FRAMES; i++)
+	{
+		seed = seed * 1664525u + 1013904223u;
+
+		float noise = ((float)(seed >> 8) / 8388608.0f) - 1.0f;
+		float window = 0.5f - 0.5f * cosf(2.0f * (float)MA_PI * (float)i / (float)(AUDIO_CALIBRATION_CLICK_FRAMES - 1));
+
+		burst[i] = AUDIO_CALIBRATION_CLICK_LEVEL * noise * window;
+	}
+
+	for (ma_uint32 k = 0; k < clickCount; k++)
+	{
+		clickFrames[k] = k * interval + ((k * 7919u) % (interval / 4 + 1));
+
+		for (int i = 0; (i < AUDIO_CALIBRATION_CLICK_FRAMES) && (clickFrames[k] + i < frameCount); i++) reference[clickFrames[k] + i] = burst[i];
+	}
+}
+
+// Replaces the mix with the click train and records the loopback signal, called by the audio thread
+static void ProcessLatencyCalibration(float* framesOut, const float* framesIn, ma_uint32 frameCount, ma_uint32 channels)
+{
+	ma_uint32 position = AUDIO.Calibration.position;
+
+	for (ma_uint32 i = 0; (i < frameCount) && (position < AUDIO.Calibration.frameCount); i++, position++)
+	{
+		const float click = (position < AUDIO.Calibration.emitFrames) ? AUDIO.Calibration.reference[position] : 0.0f;
+
+		for (ma_uint32 c = 0; c < channels; c++) framesOut[i * channels + c] = click;
+
+		float captured = (framesIn != NULL) ? framesIn[i] : 0.0f;
+
+		// Synthetic loopback is a simulated acoustic path, the emitted signal reaches the capture a fixed number of frames later
+		if (AUDIO.Calibration.syntheticDelay > 0)
+		{
+			const ma_uint32 delay = AUDIO.Calibration.syntheticDelay;
+			if ((position >= delay) && (position - delay < AUDIO.Calibration.emitFrames)) captured += AUDIO.Calibration.reference[position - delay];
+		}
+
+		AUDIO.Calibration.recording[position] = captured;
+	}
+
+	// Silence after the click train, the game mix stays muted until calibration ends
+	if (position >= AUDIO.Calibration.frameCount) memset(framesOut, 0, frameCount * channels * sizeof(float));
+
+	// Recording is published with the flag, the calibrating thread polls it without the lock
+	AUDIO.Calibration.position = position;
+	if (position >= AUDIO.Calibration.frameCount) AUDIO.Calibration.active.store(false, std::memory_order_release);
+}
+
+// Finds the lag that best aligns the recording with the click train
+// NOTE: Reference is zero outside clicks, so only click frames take part in the correlation.
+// Correlation magnitude is compared, a loop that inverts polarity still locks on the right lag
+static ma_uint32 FindCalibrationLag(const ma_uint32* clickFrames, ma_uint32 clickCount, ma_uint32 maxLag, float* confidence)
+{
+	const float* reference = AUDIO.Calibration.reference;
+	const float* recording = AUDIO.Calibration.recording;
+
+	double referenceEnergy = 0.0;
+	for (ma_uint32 k = 0; k < clickCount; k++)
+	{
+		for (int i = 0; i < AUDIO_CALIBRATION_CLICK_FRAMES; i++) referenceEnergy += (double)reference[clickFrames[k] + i] * reference[clickFrames[k] + i];
+	}
+
+	double bestCorrelation = 0.0;
+	ma_uint32 bestLag = 0;
+
+	for (ma_uint32 lag = 0; lag <= maxLag; lag++)
+	{
+		double correlation = 0.0;
+
+		for (ma_uint32 k = 0; k < clickCount; k++)
+		{
+			const float* ref = reference + clickFrames[k];
+			const float* rec = recording + clickFrames[k] + lag;
+
+			for (int i = 0; i < AUDIO_CALIBRATION_CLICK_FRAMES; i++) correlation += (double)ref[i] * rec[i];
+		}
+
+		if (fabs(correlation) > fabs(bestCorrelation))
+		{
+			bestCorrelation = correlation;
+			bestLag = lag;
+		}
+	}
+
+	// Normalized correlation at the best lag, 1.0 is a perfect (scaled) copy
+	double recordingEnergy = 0.0;
+	for (ma_uint32 k = 0; k < clickCount; k++)
+	{
+		for (int i = 0; i < AUDIO_CALIBRATION_CLICK_FRAMES; i++) recordingEnergy += (double)recording[clickFrames[k] + bestLag + i] * recording[clickFrames[k] + bestLag + i];
+	}
+
+	*confidence = ((referenceEnergy > 0.0) && (recordingEnergy > 0.0)) ? (float)(fabs(bestCorrelation) / sqrt(referenceEnergy * recordingEnergy)) : 0.0f;
+
+	return bestLag;
+}
+
+// Re-initializes the device with the given type, sounds are adapted to the new device sample rate
+static ma_result RestartAudioDevice(ma_device_type deviceType)
+{
+	StopAudioBuffersRebake();
+	ma_device_uninit(&AUDIO.System.device);
+
+	// No callback until the new device starts, unloaded buffers must not be rebased
+	ma_mutex_lock(&AUDIO.System.lock);
+	UnlinkUnloadedAudioBuffers();
+	ma_mutex_unlock(&AUDIO.System.lock);
+
+	ma_result result = InitAudioDevice(AUDIO.System.options, deviceType);
+	if (result != MA_SUCCESS) return result;
+
+	RebaseAudioBuffersSampleRate();
+
+	result = ma_device_start(&AUDIO.System.device);
+	if (result != MA_SUCCESS)
+	{
+		ma_device_uninit(&AUDIO.System.device);
+		return result;
+	}
+
+	StartAudioBuffersRebake();
+
+	return MA_SUCCESS;
+}
+
+// Restores the playback device after calibration, the device is unusable if that fails
+static void RestoreAudioDevicePlayback(void)
+{
+	ma_result result = RestartAudioDevice(ma_device_type_playback);
+
+	if (result != MA_SUCCESS)
+	{
+		DEBUG_ERROR_FMT(unityLogPtr, "CALIBRATION: Failed to restore playback device (%s), closing audio device!", ma_result_description(result));
+
+		// Device is already uninitialized, closing releases the rest and clears isReady so later calls bail out
+		RiqCloseAudioDevice();
+	}
+}
+
+// Measures output latency playing a click train and recording it back through a duplex device
+// NOTE: Blocking, the game mix is muted while it runs. Synthetic loopback adds the emitted signal delayed by
+// syntheticLoopbackFrames to the captured one, useful on null backends or without a physical loop
+AudioLatencyCalibration RiqCalibrateAudioLatency(AudioCalibrationOptions options)
+{
+	AudioLatencyCalibration calibration = { 0 };
+
+	if (!AUDIO.System.isReady)
+	{
+		DEBUG_WARNING(unityLogPtr, "CALIBRATION: Audio device not ready");
+		return calibration;
+	}
+
+	if (AUDIO.System.offline)
+	{
+		DEBUG_WARNING(unityLogPtr, "CALIBRATION: Not available in offline mode");
+		return calibration;
+	}
+
+	const bool synthetic = (options.syntheticLoopbackFrames > 0);
+
+	if (options.clickCount <= 0) options.clickCount = 1;
+	if (options.clickCount > AUDIO_CALIBRATION_MAX_CLICKS) options.clickCount = AUDIO_CALIBRATION_MAX_CLICKS;
+
+	// Duplex device first, its sample rate is the one frames are measured at
+	if (RestartAudioDevice(ma_device_type_duplex) != MA_SUCCESS)
+	{
+		DEBUG_WARNING(unityLogPtr, "CALIBRATION: Failed to open duplex device, no capture device available?");
+
+		RestoreAudioDevicePlayback();
+		return calibration;
+	}
+
+	const ma_uint32 sampleRate = AUDIO.System.device.sampleRate;
+	const ma_uint32 interval = (ma_uint32)(((ma_uint64)options.clickIntervalMs * sampleRate) / 1000);
+	ma_uint32 maxLag = (ma_uint32)(((ma_uint64)options.maxLatencyMs * sampleRate) / 1000);
+	if (synthetic && (maxLag < options.syntheticLoopbackFrames)) maxLag = options.syntheticLoopbackFrames;
+
+	const ma_uint32 emitFrames = options.clickCount * interval + AUDIO_CALIBRATION_CLICK_FRAMES;
+	const ma_uint32 frameCount = emitFrames + maxLag;
+
+	ma_uint32 clickFrames[AUDIO_CALIBRATION_MAX_CLICKS] = { 0 };
+	float* reference = (float*)RIQ_CALLOC(frameCount, sizeof(float));
+	float* recording = (float*)RIQ_CALLOC(frameCount + AUDIO_CALIBRATION_CLICK_FRAMES, sizeof(float));
+
+	if ((interval > 0) && (reference != NULL) && (recording != NULL))
+	{
+		BuildCalibrationClickTrain(reference, emitFrames, clickFrames, options.clickCount, interval);
+
+		ma_mutex_lock(&AUDIO.System.lock);
+		{
+			AUDIO.Calibration.reference = reference;
+			AUDIO.Calibration.recording = recording;
+			AUDIO.Calibration.emitFrames = emitFrames;
+			AUDIO.Calibration.frameCount = frameCount;
+			AUDIO.Calibration.syntheticDelay = options.syntheticLoopbackFrames;
+			AUDIO.Calibration.position = 0;
+			AUDIO.Calibration.active.store(true);
+		}
+		ma_mutex_unlock(&AUDIO.System.lock);
+
+		// Wait for the audio thread to play and record everything, twice the expected time at most
+		ma_uint32 timeoutMs = 2 * (ma_uint32)(((ma_uint64)frameCount * 1000) / sampleRate) + 1000;
+		for (ma_uint32 waitedMs = 0; AUDIO.Calibration.active.load(std::memory_order_acquire) && (waitedMs < timeoutMs); waitedMs += 10) ma_sleep(10);
+
+		ma_mutex_lock(&AUDIO.System.lock);
+		bool completed = !AUDIO.Calibration.active.load();
+		AUDIO.Calibration.active.store(false);
+		ma_mutex_unlock(&AUDIO.System.lock);
+
+		if (completed)
+		{
+			float confidence = 0.0f;
+			ma_uint32 lag = FindCalibrationLag(clickFrames, options.clickCount, maxLag, &confidence);
+
+			// Capture side holds at least one period before delivering it, the rest of the round trip is output
+			ma_uint32 inputFrames = 0;
+			if (AUDIO.System.device.capture.internalSampleRate > 0)
+			{
+				inputFrames = (ma_uint32)(((ma_uint64)AUDIO.System.device.capture.internalPeriodSizeInFrames * sampleRate) / AUDIO.System.device.capture.internalSampleRate);
+			}
+
+			calibration.success = (confidence >= AUDIO_CALIBRATION_MIN_CONFIDENCE) ? 1 : 0;
+			calibration.sampleRate = sampleRate;
+			calibration.roundTripFrames = lag;
+			calibration.inputLatencyFrames = (inputFrames < lag) ? inputFrames : lag;
+			calibration.outputLatencyFrames = lag - calibration.inputLatencyFrames;
+			calibration.roundTripMs = (float)lag * 1000.0f / (float)sampleRate;
+			calibration.outputLatencyMs = (float)calibration.outputLatencyFrames * 1000.0f / (float)sampleRate;
+			calibration.confidence = confidence;
+
+			if (calibration.success) DEBUG_LOG_FMT(unityLogPtr, "CALIBRATION: Round trip %i frames (%.2f ms), output latency %i frames (%.2f ms)", (int)lag, calibration.roundTripMs, (int)calibration.outputLatencyFrames, calibration.outputLatencyMs);
+			else DEBUG_WARNING_FMT(unityLogPtr, "CALIBRATION: Click train not found in the loopback signal (confidence %.2f)", confidence);
+		}
+		else DEBUG_WARNING(unityLogPtr, "CALIBRATION: Timed out waiting for the audio device");
+	}
+	else DEBUG_WARNING(unityLogPtr, "CALIBRATION: Failed to allocate calibration buffers");
+
+	RestoreAudioDevicePlayback();
+
+	AUDIO.Calibration.reference = NULL;
+	AUDIO.Calibration.recording = NULL;
+
+	RIQ_FREE(reference);
+	RIQ_FREE(recording);
+
+	return calibration;
+}
+
+// ================================================================================
+#pragma endregion
+// ================================================================================
+
+// ================================================================================
+#pragma region Metering
+// ================================================================================
+
+static std::thread spectrumThread;
+
+// Publishes a snapshot into the slot readers are not looking at, then flips the sequence
+// NOTE: Single writer (audio thread or spectrum thread), any number of readers. Slots are atomic words so
+// a reader overlapping the write is a stale read caught by the sequence check, never a data race
+static void PublishSnapshot(std::atomic<unsigned int>* sequence, std::atomic<unsigned int>* snapshots, size_t snapshotSize, const void* snapshot)
+{
+	const size_t wordCount = snapshotSize / sizeof(unsigned int);
+	unsigned int next = sequence->load(std::memory_order_relaxed) + 1;
+	std::atomic<unsigned int>* slot = snapshots + (next & 1) * wordCount;
+
+	// Pairs with the reader fence, a reader seeing any of these words also sees the previous sequence bump
+	std::atomic_thread_fence(std::memory_order_release);
+
+	for (size_t i = 0; i < wordCount; i++)
+	{
+		unsigned int word;
+		memcpy(&word, (const unsigned char*)snapshot + i * sizeof(unsigned int), sizeof(unsigned int));
+		slot[i].store(word, std::memory_order_relaxed);
+	}
+
+	sequence->store(next, std::memory_order_release);
+}
+
+// Reads the latest snapshot without locking, retries if the writer got to the slot while copying
+// NOTE: Copy goes through scratch, snapshot is only written when consistent. Returns 0 (snapshot untouched)
+// if the writer kept lapping the reader, callers report that the same way as nothing published yet
+template <typename T>
+static unsigned int ReadSnapshot(const std::atomic<unsigned int>* sequence, const std::atomic<unsigned int>* snapshots, T* snapshot)
+{
+	static_assert((sizeof(T) % sizeof(unsigned int)) == 0, "Snapshots are published as whole words");
+
+	const size_t wordCount = sizeof(T) / sizeof(unsigned int);
+	unsigned int scratch[sizeof(T) / sizeof(unsigned int)];
+
+	for (int attempt = 0; attempt < 8; attempt++)
+	{
+		unsigned int current = sequence->load(std::memory_order_acquire);
+		const std::atomic<unsigned int>* slot = snapshots + (current & 1) * wordCount;
+
+		for (size_t i = 0; i < wordCount; i++) scratch[i] = slot[i].load(std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_acquire);
+
+		if (sequence->load(std::memory_order_relaxed) == current)
+		{
+			memcpy(snapshot, scratch, sizeof(T));
+			return current;
+		}
+	}
+
+	return 0;
+}
+
+// Accumulates frames into a meter, a snapshot is published every AUDIO_METER_WINDOW_FRAMES frames
+static void UpdateAudioMeter(AudioMeter* meter, const float* frames, ma_uint32 frameCount, ma_uint32 channels, float gain)
+{
+	if (channels > AUDIO_METER_MAX_CHANNELS) channels = AUDIO_METER_MAX_CHANNELS;
+
+	const ma_uint32 stride = channels;
+	ma_uint32 frame = 0;
+
+	while (frame < frameCount)
+	{
+		ma_uint32 framesToWindow = AUDIO_METER_WINDOW_FRAMES - meter->frameCount;
+		ma_uint32 framesNow = ((frameCount - frame) < framesToWindow) ? (frameCount - frame) : framesToWindow;
+
+		for (ma_uint32 c = 0; c < channels; c++)
+		{
+			const float* sample = frames + (frame * stride) + c;
+			float peak = meter->peak[c];
+			float sumSq = 0.0f;
+
+			for (ma_uint32 i = 0; i < framesNow; i++, sample += stride)
+			{
+				float value = fabsf(*sample);
+				if (value > peak) peak = value;
+				sumSq += value * value;
+			}
+
+			meter->peak[c] = peak;
+			meter->sumSq[c] += sumSq;
+		}
+
+		frame += framesNow;
+		meter->frameCount += framesNow;
+
+		if (meter->frameCount >= AUDIO_METER_WINDOW_FRAMES)
+		{
+			AudioMeterLevels levels = { 0 };
+			levels.sequence = meter->sequence.load(std::memory_order_relaxed) + 1;
+			levels.channels = channels;
+
+			for (ma_uint32 c = 0; c < channels; c++)
+			{
+				levels.peak[c] = meter->peak[c] * gain;
+				levels.rms[c] = sqrtf(meter->sumSq[c] / (float)meter->frameCount) * gain;
+
+				meter->peak[c] = 0.0f;
+				meter->sumSq[c] = 0.0f;
+			}
+
+			meter->frameCount = 0;
+			PublishSnapshot(&meter->sequence, meter->snapshots[0], sizeof(AudioMeterLevels), &levels);
+		}
+	}
+}
+
+// Feeds the spectrum ring with the mono downmix of the final mix, called by the audio thread
+static void FeedAudioSpectrum(const float* frames, ma_uint32 frameCount, ma_uint32 channels)
+{
+	const ma_uint32 mask = AUDIO_SPECTRUM_RING_SIZE - 1;
+	const float scale = 1.0f / (float)channels;
+	unsigned int writePos = AUDIO.Spectrum.writePos.load(std::memory_order_relaxed);
+
+	// Batch end goes out before the stores and pairs with the spectrum thread fence, a sample it copied
+	// from this batch makes its lap check see the whole batch, however long
+	AUDIO.Spectrum.writeEnd.store(writePos + frameCount, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	for (ma_uint32 i = 0; i < frameCount; i++, writePos++)
+	{
+		float sum = 0.0f;
+		for (ma_uint32 c = 0; c < channels; c++) sum += frames[i * channels + c];
+
+		AUDIO.Spectrum.ring[writePos & mask].store(sum * scale, std::memory_order_relaxed);
+	}
+
+	AUDIO.Spectrum.writePos.store(writePos, std::memory_order_release);
+}
+
+// In-place radix-2 FFT on split real/imaginary arrays, fixed AUDIO_SPECTRUM_SIZE
+// NOTE: Twiddles are laid out stage after stage so butterflies of a stage read them contiguously
+static void ComputeSpectrumFFT(float* re, float* im, const float* twiddleRe, const float* twiddleIm, const ma_uint32* bitReverse)
+{
+	const ma_uint32 size = AUDIO_SPECTRUM_SIZE;
+
+	for (ma_uint32 i = 0; i < size; i++)
+	{
+		ma_uint32 j = bitReverse[i];
+		if (j > i)
+		{
+			float tr = re[i]; re[i] = re[j]; re[j] = tr;
+			float ti = im[i]; im[i] = im[j]; im[j] = ti;
+		}
+	}
+
+	const float* stageRe = twiddleRe;
+	const float* stageIm = twiddleIm;
+
+	for (ma_uint32 half = 1; half < size; half *= 2)
+	{
+		for (ma_uint32 block = 0; block < size; block += half * 2)
+		{
+			float* aRe = re + block;
+			float* aIm = im + block;
+			float* bRe = aRe + half;
+			float* bIm = aIm + half;
+			ma_uint32 k = 0;
+
+#if defined(RIQ_SIMD_SSE2)
+			for (; k + 4 <= half; k += 4)
+			{
+				__m128 wr = _mm_loadu_ps(stageRe + k);
+				__m128 wi = _mm_loadu_ps(stageIm + k);
+				__m128 br = _mm_loadu_ps(bRe + k);
+				__m128 bi = _mm_loadu_ps(bIm + k);
+
+				__m128 tr = _mm_sub_ps(_mm_mul_ps(br, wr), _mm_mul_ps(bi, wi));
+				__m128 ti = _mm_add_ps(_mm_mul_ps(br, wi), _mm_mul_ps(bi, wr));
+
+				__m128 ar = _mm_loadu_ps(aRe + k);
+				__m128 ai = _mm_loadu_ps(aIm + k);
+
+				_mm_storeu_ps(bRe + k, _mm_sub_ps(ar, tr));
+				_mm_storeu_ps(bIm + k, _mm_sub_ps(ai, ti));
+				_mm_storeu_ps(aRe + k, _mm_add_ps(ar, tr));
+				_mm_storeu_ps(aIm + k, _mm_add_ps(ai, ti));
+			}
+#endif
+			for (; k < half; k++)
+			{
+				float tr = bRe[k] * stageRe[k] - bIm[k] * stageIm[k];
+				float ti = bRe[k] * stageIm[k] + bIm[k] * stageRe[k];
+
+				bRe[k] = aRe[k] - tr;
+				bIm[k] = aIm[k] - ti;
+				aRe[k] += tr;
+				aIm[k] += ti;
+			}
+		}
+
+		stageRe += half;
+		stageIm += half;
+	}
+}
+
+// Spectrum thread, computes a windowed FFT of the latest mix samples every AUDIO_SPECTRUM_INTERVAL_MS
+static void RunAudioSpectrum(void)
+{
+	const ma_uint32 size = AUDIO_SPECTRUM_SIZE;
+	const ma_uint32 mask = AUDIO_SPECTRUM_RING_SIZE - 1;
+
+	std::vector<float> window(size), re(size), im(size), twiddleRe(size), twiddleIm(size), magnitudes(size / 2);
+	std::vector<ma_uint32> bitReverse(size);
+
+	ma_uint32 bits = 0;
+	while ((1u << bits) < size) bits++;
+
+	float windowSum = 0.0f;
+	for (ma_uint32 i = 0; i < size; i++)
+	{
+		window[i] = 0.5f - 0.5f * cosf(2.0f * (float)MA_PI * (float)i / (float)size);
+		windowSum += window[i];
+
+		ma_uint32 reversed = 0;
+		for (ma_uint32 b = 0; b < bits; b++) reversed |= ((i >> b) & 1) << (bits - 1 - b);
+		bitReverse[i] = reversed;
+	}
+
+	for (ma_uint32 half = 1, offset = 0; half < size; offset += half, half *= 2)
+	{
+		for (ma_uint32 k = 0; k < half; k++)
+		{
+			twiddleRe[offset + k] = cosf(-(float)MA_PI * (float)k / (float)half);
+			twiddleIm[offset + k] = sinf(-(float)MA_PI * (float)k / (float)half);
+		}
+	}
+
+	// Full scale sine reads 1.0f on its bin
+	const float scale = 2.0f / windowSum;
+	unsigned int lastPos = AUDIO.Spectrum.writePos.load(std::memory_order_acquire);
+
+	while (AUDIO.Spectrum.enabled)
+	{
+		ma_sleep(AUDIO_SPECTRUM_INTERVAL_MS);
+
+		unsigned int writePos = AUDIO.Spectrum.writePos.load(std::memory_order_acquire);
+		if (writePos == lastPos) continue;
+		lastPos = writePos;
+
+		for (ma_uint32 i = 0; i < size; i++)
+		{
+			re[i] = AUDIO.Spectrum.ring[(writePos - size + i) & mask].load(std::memory_order_relaxed) * window[i];
+			im[i] = 0.0f;
+		}
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+
+		// Audio thread lapped the samples while copying (or is writing over them), try again next time
+		if ((AUDIO.Spectrum.writeEnd.load(std::memory_order_relaxed) - writePos) > (AUDIO_SPECTRUM_RING_SIZE - size)) continue;
+
+		ComputeSpectrumFFT(re.data(), im.data(), twiddleRe.data(), twiddleIm.data(), bitReverse.data());
+
+		for (ma_uint32 i = 0; i < size / 2; i++) magnitudes[i] = sqrtf(re[i] * re[i] + im[i] * im[i]) * scale;
+
+		PublishSnapshot(&AUDIO.Spectrum.sequence, AUDIO.Spectrum.snapshots[0], (AUDIO_SPECTRUM_SIZE/2)*sizeof(float), magnitudes.data());
+	}
+}
+
+static void StopAudioSpectrum(void)
+{
+	AUDIO.Spectrum.enabled = false;
+	if (spectrumThread.joinable()) spectrumThread.join();
+}
+
+void RiqEnableSpectrum(bool enable)
+{
+	if (enable == (bool)AUDIO.Spectrum.enabled) return;
+
+	if (enable)
+	{
+		AUDIO.Spectrum.enabled = true;
+		spectrumThread = std::thread(RunAudioSpectrum);
+	}
+	else StopAudioSpectrum();
+}
+
+int RiqGetSpectrum(float* magnitudesOut, int binCount)
+{
+	float magnitudes[AUDIO_SPECTRUM_SIZE / 2];
+
+	if ((magnitudesOut == NULL) || (binCount <= 0)) return 0;
+	if (binCount > AUDIO_SPECTRUM_SIZE / 2) binCount = AUDIO_SPECTRUM_SIZE / 2;
+
+	if (ReadSnapshot(&AUDIO.Spectrum.sequence, AUDIO.Spectrum.snapshots[0], &magnitudes) == 0) return 0;
+
+	memcpy(magnitudesOut, magnitudes, binCount * sizeof(float));
+
+	return binCount;
+}
+
+AudioMeterLevels RiqGetMasterMeter(void)
+{
+	AudioMeterLevels levels = { 0 };
+
+	// A torn read is never returned, levels stay zeroed (sequence 0) and the caller polls again
+	if (ReadSnapshot(&AUDIO.Meter.sequence, AUDIO.Meter.snapshots[0], &levels) == 0) levels.sequence = 0;
+
+	return levels;
+}
+
+bool RiqEnableSoundMeter(Sound sound)
+{
+	AudioBuffer* buffer = sound.stream.buffer;
+	if (buffer == NULL) return false;
+	if (buffer->meter.load() != NULL) return true;
+
+	AudioMeter* meter = (AudioMeter*)RIQ_CALLOC(1, sizeof(AudioMeter));
+	if (meter == NULL) return false;
+
+	// Published by the atomic store, the mixer starts accumulating on its next pass
+	AudioMeter* expected = NULL;
+	if (!buffer->meter.compare_exchange_strong(expected, meter, std::memory_order_release)) RIQ_FREE(meter);
+
+	return true;
+}
+
+void RiqDisableSoundMeter(Sound sound)
+{
+	AudioBuffer* buffer = sound.stream.buffer;
+	if (buffer == NULL) return;
+
+	// Game lock waits out other game threads still reading the meter, retiring waits out the audio thread
+	ma_spinlock_lock(&AUDIO.System.gameLock);
+	AudioMeter* meter = buffer->meter.exchange(NULL);
+	ma_spinlock_unlock(&AUDIO.System.gameLock);
+
+	if (meter != NULL) RetireAudioMemory(meter, ReleaseMemory);
+}
+
+AudioMeterLevels RiqGetSoundMeter(Sound sound)
+{
+	AudioMeterLevels levels = { 0 };
+
+	AudioBuffer* buffer = sound.stream.buffer;
+	if (buffer == NULL) return levels;
+
+	ma_spinlock_lock(&AUDIO.System.gameLock);
+	{
+		AudioMeter* meter = buffer->meter.load(std::memory_order_acquire);
+		if ((meter != NULL) && (ReadSnapshot(&meter->sequence, meter->snapshots[0], &levels) == 0)) levels.sequence = 0;
+	}
+	ma_spinlock_unlock(&AUDIO.System.gameLock);
+
+	return levels;
+}
+
+// ================================================================================
+#pragma endregion
+// ================================================================================
+
+// ================================================================================
+#pragma region Wave
+// ================================================================================
+
+Wave RiqLoadWave(const char* filePath)
+{
+	Wave wave = { 0 };
+
+	unsigned int fileSize = 0;
+	unsigned char* fileData = LoadFileData(filePath, &fileSize);
+
+	if (fileData != NULL) wave = RiqLoadWaveFromMemory(GetFileExtension(filePath), fileData, fileSize);
+
+	RIQ_FREE(fileData);
+
+	return wave;
+}
+
+Wave RiqLoadWaveFromMemory(const char* fileType, const unsigned char* fileData, int dataSize)
+{
+	Wave wave = { 0 };
+
+	if (false) {}
+#if defined(SUPPORT_FILEFORMAT_WAV)
+	else if (strcmp(fileType, ".wav") == 0)
+	{
+		drwav wav = { 0 };
+		bool success = drwav_init_memory(&wav, fileData, dataSize, NULL);
+
+		if (success)
+		{
+			wave.frameCount = (unsigned int)wav.totalPCMFrameCount;
+			wave.sampleRate = wav.sampleRate;
+			wave.sampleSize = 16;
+			wave.channels = wav.channels;
+			wave.data = (short*)RIQ_MALLOC(wave.frameCount * wave.channels * sizeof(short));
+
+			// NOTE: We are forcing conversion to 16bit sample size on reading
+			drwav_read_pcm_frames_s16(&wav, wav.totalPCMFrameCount, (drwav_int16*)wave.data);
+		}
+		else DEBUG_WARNING(unityLogPtr, "WAVE: Failed to load WAV data!");
+
+		drwav_uninit(&wav);
+	}
+#endif
+#if defined(SUPPORT_FILEFORMAT_OGG)
+	else if (strcmp(fileType, ".ogg") == 0)
+	{
+		stb_vorbis* oggData = stb_vorbis_open_memory((unsigned char*)fileData, dataSize, NULL, NULL);
+
+		if (oggData != NULL)
+		{
+			stb_vorbis_info info = stb_vorbis_get_info(oggData);
+
+			wave.sampleRate = info.sample_rate;
+			wave.sampleSize = 16;
+			wave.channels = info.channels;
+			wave.frameCount = (unsigned int)stb_vorbis_stream_length_in_samples(oggData);
+			wave.data = (short*)RIQ_MALLOC(wave.frameCount * wave.channels * sizeof(short));
+
+			stb_vorbis_get_samples_short_interleaved(oggData, info.channels, (short*)wave.data, wave.frameCount * wave.channels);
+			stb_vorbis_close(oggData);
+		}
+		else DEBUG_WARNING(unityLogPtr, "WAVE: Failed to load OGG data!");
+	}
+#endif
+	else DEBUG_WARNING(unityLogPtr, "WAVE: Data format not supported!");
+
+	DEBUG_LOG_FMT(unityLogPtr, "WAVE: Data loaded successfully (%i Hz, %i bit, %i channels)", wave.sampleRate, wave.sampleSize, wave.channels);
+
+	return wave;
+}
+
+void RiqUnloadWave(Wave wave)
+{
+	RIQ_FREE(wave.data);
+}
+
+// ================================================================================
+#pragma endregion
+// ================================================================================
+
+// ================================================================================
+#pragma region Wave Peaks
+// ================================================================================
+
+typedef struct WavePeaksBuildJob
+{
+	const unsigned char* data;  // Source data, interleaved frames
+	ma_format format;           // Source data format
+	ma_uint32 channels;         // Source channels
+	ma_uint32 frameCount;       // Source total frames
+	ma_uint32 binShift;         // Level 0 bin size, as a power of two
+	ma_uint32 firstBin;         // First level 0 bin to compute
+	ma_uint32 lastBin;          // One past the last level 0 bin to compute
+	WavePeak* binsOut;          // Level 0 bins
+	bool failed;                // Scratch memory could not be allocated, bins are not computed
+} WavePeaksBuildJob;
+
+// Get number of bins for a pyramid level
+static ma_uint32 GetWavePeaksLevelBinCount(ma_uint32 frameCount, ma_uint32 binShift, ma_uint32 level)
+{
+	ma_uint32 shift = binShift + level;
+	return (ma_uint32)(((ma_uint64)frameCount + ((ma_uint64)1 << shift) - 1) >> shift);
+}
+
+// Get offset (in bins, not counting channels) of a pyramid level inside the packed data
+static ma_uint32 GetWavePeaksLevelOffset(ma_uint32 frameCount, ma_uint32 binShift, ma_uint32 level)
+{
+	ma_uint32 offset = 0;
+
+	for (ma_uint32 i = 0; i < level; i++) offset += GetWavePeaksLevelBinCount(frameCount, binShift, i);
+
+	return offset;
+}
+
+// Accumulates min, max and sum of squares of interleaved float frames, one result per channel
+// NOTE: minOut, maxOut and sumSqOut must be initialized by the caller
+static void AccumulatePeakFrames(const float* samples, ma_uint32 frameCount, ma_uint32 channels, float* minOut, float* maxOut, float* sumSqOut)
+{
+	ma_uint32 sampleCount = frameCount * channels;
+	ma_uint32 sample = 0;
+
+#if defined(RIQ_SIMD_SSE2)
+	// Every SSE lane always maps to the same channel when the channel count divides 4 (mono, stereo, quad)
+	if ((4 % channels) == 0 && sampleCount >= 4)
+	{
+		__m128 vMin = _mm_set1_ps(FLT_MAX);
+		__m128 vMax = _mm_set1_ps(-FLT_MAX);
+		__m128 vSumSq = _mm_setzero_ps();
+
+		for (; sample + 4 <= sampleCount; sample += 4)
+		{
+			__m128 v = _mm_loadu_ps(samples + sample);
+			vMin = _mm_min_ps(vMin, v);
+			vMax = _mm_max_ps(vMax, v);
+			vSumSq = _mm_add_ps(vSumSq, _mm_mul_ps(v, v));
+		}
+
+		float lanesMin[4], lanesMax[4], lanesSumSq[4];
+		_mm_storeu_ps(lanesMin, vMin);
+		_mm_storeu_ps(lanesMax, vMax);
+		_mm_storeu_ps(lanesSumSq, vSumSq);
+
+		for (ma_uint32 lane = 0; lane < 4; lane++)
+		{
+			ma_uint32 c = lane % channels;
+			if (lanesMin[lane] < minOut[c]) minOut[c] = lanesMin[lane];
+			if (lanesMax[lane] > maxOut[c]) maxOut[c] = lanesMax[lane];
+			sumSqOut[c] += lanesSumSq[lane];
+		}
+	}
+#endif
+
+	// Remaining samples (or every sample for odd channel layouts)
+	for (; sample < sampleCount; sample++)
+	{
+		ma_uint32 c = sample % channels;
+		float v = samples[sample];
+
+		if (v < minOut[c]) minOut[c] = v;
+		if (v > maxOut[c]) maxOut[c] = v;
+		sumSqOut[c] += v * v;
+	}
+}
+
+// Computes a range of level 0 bins, runs on worker threads
+static void BuildWavePeaksLevel0(WavePeaksBuildJob* job)
+{
+	const ma_uint32 binSize = 1u << job->binShift;
+	const ma_uint32 channels = job->channels;
+	const ma_uint32 bytesPerFrame = ma_get_bytes_per_frame(job->format, channels);
+
+	// Non float data is converted one bin at a time into a scratch buffer
+	float* scratch = NULL;
+	if (job->format != ma_format_f32) scratch = (float*)RIQ_MALLOC(binSize * channels * sizeof(float));
+
+	float* minValues = (float*)RIQ_MALLOC(channels * 3 * sizeof(float));
+
+	if ((minValues == NULL) || ((job->format != ma_format_f32) && (scratch == NULL)))
+	{
+		RIQ_FREE(minValues);
+		RIQ_FREE(scratch);
+		job->failed = true;
+		return;
+	}
+
+	float* maxValues = minValues + channels;
+	float* sumSqValues = maxValues + channels;
+
+	for (ma_uint32 bin = job->firstBin; bin < job->lastBin; bin++)
+	{
+		ma_uint32 firstFrame = bin << job->binShift;
+		ma_uint32 framesInBin = job->frameCount - firstFrame;
+		if (framesInBin > binSize) framesInBin = binSize;
+
+		const unsigned char* binData = job->data + ((size_t)firstFrame * bytesPerFrame);
+		const float* samples = (const float*)binData;
+
+		if (scratch != NULL)
+		{
+			ma_pcm_convert(scratch, ma_format_f32, binData, job->format, (ma_uint64)framesInBin * channels, ma_dither_mode_none);
+			samples = scratch;
+		}
+
+		for (ma_uint32 c = 0; c < channels; c++)
+		{
+			minValues[c] = FLT_MAX;
+			maxValues[c] = -FLT_MAX;
+			sumSqValues[c] = 0.0f;
+		}
+
+		AccumulatePeakFrames(samples, framesInBin, channels, minValues, maxValues, sumSqValues);
+
+		WavePeak* binOut = job->binsOut + ((size_t)bin * channels);
+		for (ma_uint32 c = 0; c < channels; c++)
+		{
+			binOut[c].min = minValues[c];
+			binOut[c].max = maxValues[c];
+			binOut[c].rms = sqrtf(sumSqValues[c] / (float)framesInBin);
+		}
+	}
+
+	RIQ_FREE(minValues);
+	RIQ_FREE(scratch);
+}
+
+// Merges a range of bins of the same level into one
+// NOTE: All bins are weighted the same for rms, only the last bin of a level can be partial
+static void MergeWavePeakBins(const WavePeak* bins, ma_uint32 binCount, ma_uint32 channels, WavePeak* binOut)
+{
+	for (ma_uint32 c = 0; c < channels; c++)
+	{
+		WavePeak merged = bins[c];
+		float sumSq = merged.rms * merged.rms;
+
+		for (ma_uint32 bin = 1; bin < binCount; bin++)
+		{
+			const WavePeak* peak = &bins[(bin * channels) + c];
+
+			if (peak->min < merged.min) merged.min = peak->min;
+			if (peak->max > merged.max) merged.max = peak->max;
+			sumSq += peak->rms * peak->rms;
+		}
+
+		merged.rms = sqrtf(sumSq / (float)binCount);
+		binOut[c] = merged;
+	}
+}
+
+// Builds the whole peaks pyramid from interleaved PCM data
+static WavePeaks LoadWavePeaksFromData(const void* data, ma_format format, ma_uint32 channels, ma_uint32 sampleRate, ma_uint32 frameCount)
+{
+	WavePeaks peaks = { 0 };
+
+	if (data == NULL || format == ma_format_unknown || channels == 0 || frameCount == 0)
+	{
+		DEBUG_WARNING(unityLogPtr, "PEAKS: Invalid source data provided");
+		return peaks;
+	}
+
+	const ma_uint32 binShift = WAVE_PEAKS_BASE_BIN_SHIFT;
+
+	// Levels go on until a single bin covers the whole data
+	ma_uint32 levelCount = 1;
+	while (GetWavePeaksLevelBinCount(frameCount, binShift, levelCount - 1) > 1) levelCount++;
+
+	ma_uint32 totalBins = GetWavePeaksLevelOffset(frameCount, binShift, levelCount);
+
+	WavePeak* bins = (WavePeak*)RIQ_MALLOC((size_t)totalBins * channels * sizeof(WavePeak));
+	if (bins == NULL)
+	{
+		DEBUG_WARNING(unityLogPtr, "PEAKS: Failed to allocate memory for peaks");
+		return peaks;
+	}
+
+	// Level 0 is computed from the samples, split in contiguous chunks across threads for long data
+	ma_uint32 level0Bins = GetWavePeaksLevelBinCount(frameCount, binShift, 0);
+	ma_uint32 threadCount = 1;
+
+	if (level0Bins >= WAVE_PEAKS_PARALLEL_MIN_BINS)
+	{
+		threadCount = std::thread::hardware_concurrency();
+		if (threadCount == 0) threadCount = 1;
+		if (threadCount > level0Bins / (WAVE_PEAKS_PARALLEL_MIN_BINS / 4)) threadCount = level0Bins / (WAVE_PEAKS_PARALLEL_MIN_BINS / 4);
+	}
+
+	std::vector<WavePeaksBuildJob> jobs(threadCount);
+	std::vector<std::thread> workers;
+
+	for (ma_uint32 i = 0; i < threadCount; i++)
+	{
+		WavePeaksBuildJob* job = &jobs[i];
+		job->data = (const unsigned char*)data;
+		job->format = format;
+		job->channels = channels;
+		job->frameCount = frameCount;
+		job->binShift = binShift;
+		job->firstBin = (ma_uint32)(((ma_uint64)level0Bins * i) / threadCount);
+		job->lastBin = (ma_uint32)(((ma_uint64)level0Bins * (i + 1)) / threadCount);
+		job->binsOut = bins;
+		job->failed = false;
+
+		// Calling thread takes the last chunk
+		if (i + 1 < threadCount) workers.emplace_back(BuildWavePeaksLevel0, job);
+		else BuildWavePeaksLevel0(job);
+	}
+
+	for (std::thread& worker : workers) worker.join();
+
+	for (const WavePeaksBuildJob& job : jobs)
+	{
+		if (job.failed)
+		{
+			DEBUG_WARNING(unityLogPtr, "PEAKS: Failed to allocate memory for peaks");
+			RIQ_FREE(bins);
+			return peaks;
+		}
+	}
+
+	// Upper levels are built by merging pairs of bins of the level below
+	for (ma_uint32 level = 1; level < levelCount; level++)
+	{
+		ma_uint32 srcBinCount = GetWavePeaksLevelBinCount(frameCount, binShift, level - 1);
+		const WavePeak* src = bins + ((size_t)GetWavePeaksLevelOffset(frameCount, binShift, level - 1) * channels);
+		WavePeak* dst = bins + ((size_t)GetWavePeaksLevelOffset(frameCount, binShift, level) * channels);
+
+		for (ma_uint32 bin = 0; bin < srcBinCount; bin += 2)
+		{
+			ma_uint32 pairCount = ((bin + 1) < srcBinCount) ? 2 : 1;
+			MergeWavePeakBins(src + ((size_t)bin * channels), pairCount, channels, dst + ((size_t)(bin / 2) * channels));
+		}
+	}
+
+	peaks.frameCount = frameCount;
+	peaks.sampleRate = sampleRate;
+	peaks.channels = channels;
+	peaks.baseBinShift = binShift;
+	peaks.levelCount = levelCount;
+	peaks.data = bins;
+
+	DEBUG_LOG_FMT(unityLogPtr, "PEAKS: Peaks generated successfully (%i levels, %i bins)", levelCount, totalBins);
+
+	return peaks;
+}
+
+WavePeaks RiqLoadWavePeaks(Wave wave)
+{
+	ma_format format = ((wave.sampleSize == 8) ? ma_format_u8 : ((wave.sampleSize == 16) ? ma_format_s16 : ma_format_f32));
+
+	return LoadWavePeaksFromData(wave.data, format, wave.channels, wave.sampleRate, wave.frameCount);
+}
+
+WavePeaks RiqLoadWavePeaksFromSound(Sound sound)
+{
+	WavePeaks peaks = { 0 };
+
+	// NOTE: Buffer values are used instead of the sound ones, data could have been re-derived at a new sample rate,
+	// the rebake lock keeps data from being swapped while peaks are generated
+	AudioBuffer* buffer = sound.stream.buffer;
+	if (buffer != NULL)
+	{
+		if (AUDIO.System.isReady) ma_mutex_lock(&AUDIO.System.rebakeLock);
+		peaks = LoadWavePeaksFromData(buffer->data, AUDIO_DEVICE_FORMAT, AUDIO_DEVICE_CHANNELS, buffer->sampleRate, buffer->sizeInFrames);
+		if (AUDIO.System.isReady) ma_mutex_unlock(&AUDIO.System.rebakeLock);
+	}
+
+	return peaks;
+}
+
+void RiqUnloadWavePeaks(WavePeaks peaks)
+{
+	RIQ_FREE(peaks.data);
+}
+
+int RiqGetWavePeaks(WavePeaks peaks, unsigned int startFrame, unsigned int frameCount, WavePeak* binsOut, int binCount)
+{
+	if (peaks.data == NULL || peaks.channels == 0 || binsOut == NULL || binCount <= 0 || frameCount == 0) return 0;
+	if (startFrame >= peaks.frameCount) return 0;
+
+	if (frameCount > peaks.frameCount - startFrame) frameCount = peaks.frameCount - startFrame;
+
+	// Pick the coarsest level whose bins still fit inside one output bin, that way every
+	// output bin merges just a couple of stored bins, no matter the zoom
+	ma_uint32 framesPerBin = frameCount / (ma_uint32)binCount;
+	ma_uint32 level = 0;
+	while ((level + 1) < peaks.levelCount && ((ma_uint64)1 << (peaks.baseBinShift + level + 1)) <= framesPerBin) level++;
+
+	const ma_uint32 shift = peaks.baseBinShift + level;
+	const ma_uint32 levelBinCount = GetWavePeaksLevelBinCount(peaks.frameCount, peaks.baseBinShift, level);
+	const WavePeak* levelBins = (const WavePeak*)peaks.data + ((size_t)GetWavePeaksLevelOffset(peaks.frameCount, peaks.baseBinShift, level) * peaks.channels);
+
+	for (int i = 0; i < binCount; i++)
+	{
+		ma_uint64 firstFrame = startFrame + (((ma_uint64)frameCount * i) / binCount);
+		ma_uint64 lastFrame = startFrame + (((ma_uint64)frameCount * (i + 1)) / binCount);
+
+		ma_uint32 firstBin = (ma_uint32)(firstFrame >> shift);
+		ma_uint32 lastBin = (ma_uint32)((lastFrame + ((ma_uint64)1 << shift) - 1) >> shift);
+		if (lastBin > levelBinCount) lastBin = levelBinCount;
+		if (lastBin <= firstBin) lastBin = firstBin + 1;
+
+		MergeWavePeakBins(levelBins + ((size_t)firstBin * peaks.channels), lastBin - firstBin, peaks.channels, binsOut + ((size_t)i * peaks.channels));
+	}
+
+	return binCount;
+}
+
+// ================================================================================
+#pragma endregion
+// ================================================================================
+
+// ================================================================================
+#pragma region Time Stretch
+// ================================================================================
+
+// WSOLA time stretcher state, changes tempo without changing pitch
+typedef struct TimeStretch
+{
+	ma_uint32 channels;             // Data channels
+	ma_uint32 windowSize;           // Segment size in frames (N)
+	ma_uint32 hopSize;              // Output hop in frames (N/2), segments overlap by half
+	ma_uint32 searchRange;          // Max segment offset searched around the ideal position, in frames
+
+	float* window;                  // Hann window, windowSize
+	float* segment;                 // Current windowed segment, windowSize * channels
+	float* overlap;                 // Second half of the previous windowed segment, hopSize * channels
+	float* output;                  // Output frames ready to be read, hopSize * channels
+	float* monoNatural;             // Mono natural continuation of the previous segment, hopSize
+	float* monoSearch;              // Mono search region, hopSize + 2 * searchRange
+
+	ma_uint32 outputPos;            // Next output frame to be read
+	ma_uint32 outputCount;          // Number of output frames ready
+
+	double timelinePos;             // Source position matching the next output frame, advances by tempo per frame
+	double analysisPos;             // Ideal source position of the next segment
+	double previousPos;             // Actual source position of the previous segment, after search
+	ma_uint32 expectedCursor;       // Buffer cursor written on the last read, any other value means a seek
+	ma_uint32 expectedSize;         // Buffer size the positions refer to, any other value means data was re-derived
+} TimeStretch;
+
+// Dot product, used for segment similarity search
+static float DotProduct(const float* a, const float* b, ma_uint32 count)
+{
+	float result = 0.0f;
+	ma_uint32 i = 0;
+
+#if defined(RIQ_SIMD_SSE2)
+	__m128 sum = _mm_setzero_ps();
+	for (; i + 4 <= count; i += 4) sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+
+	float lanes[4];
+	_mm_storeu_ps(lanes, sum);
+	result = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+
+	for (; i < count; i++) result += a[i] * b[i];
+
+	return result;
+}
+
+static TimeStretch* LoadTimeStretch(ma_uint32 channels, ma_uint32 sampleRate)
+{
+	TimeStretch* stretch = (TimeStretch*)RIQ_CALLOC(1, sizeof(TimeStretch));
+	if (stretch == NULL) return NULL;
+
+	// ~20 ms segments, power of two
+	ma_uint32 windowSize = 256;
+	while (windowSize < (sampleRate / 50)) windowSize *= 2;
+
+	stretch->channels = channels;
+	stretch->windowSize = windowSize;
+	stretch->hopSize = windowSize / 2;
+	stretch->searchRange = windowSize / 8;
+
+	stretch->window = (float*)RIQ_MALLOC(windowSize * sizeof(float));
+	stretch->segment = (float*)RIQ_MALLOC(windowSize * channels * sizeof(float));
+	stretch->overlap = (float*)RIQ_MALLOC(stretch->hopSize * channels * sizeof(float));
+	stretch->output = (float*)RIQ_MALLOC(stretch->hopSize * channels * sizeof(float));
+	stretch->monoNatural = (float*)RIQ_MALLOC(stretch->hopSize * sizeof(float));
+	stretch->monoSearch = (float*)RIQ_MALLOC((stretch->hopSize + 2 * stretch->searchRange) * sizeof(float));
+
+	if ((stretch->window == NULL) || (stretch->segment == NULL) || (stretch->overlap == NULL) || (stretch->output == NULL) || (stretch->monoNatural == NULL) || (stretch->monoSearch == NULL))
+	{
+		UnloadTimeStretch(stretch);
+		return NULL;
+	}
+
+	// Periodic Hann window, sums to exactly one with 50% overlap
+	for (ma_uint32 i = 0; i < windowSize; i++) stretch->window[i] = 0.5f - 0.5f * cosf(2.0f * (float)MA_PI * (float)i / (float)windowSize);
+
+	return stretch;
+}
+
+static void UnloadTimeStretch(void* ptr)
+{
+	TimeStretch* stretch = (TimeStretch*)ptr;
+	if (stretch == NULL) return;
+
+	RIQ_FREE(stretch->window);
+	RIQ_FREE(stretch->segment);
+	RIQ_FREE(stretch->overlap);
+	RIQ_FREE(stretch->output);
+	RIQ_FREE(stretch->monoNatural);
+	RIQ_FREE(stretch->monoSearch);
+	RIQ_FREE(stretch);
+}
+
+// Wraps the first frame of a run of source frames on looping buffers, following frames wrap with a compare
+static ma_int64 WrapStretchSourceFrame(const AudioBuffer* buffer, ma_int64 frame)
+{
+	ma_int64 size = (ma_int64)buffer->sizeInFrames;
+
+	if (buffer->looping && (size > 0))
+	{
+		frame %= size;
+		if (frame < 0) frame += size;
+	}
+
+	return frame;
+}
+
+// Get pointer to a source frame of a static buffer, NULL past the data bounds (reads as silence)
+static const float* GetStretchSourceFrame(const AudioBuffer* buffer, ma_int64 frame)
+{
+	if ((frame < 0) || (frame >= (ma_int64)buffer->sizeInFrames)) return NULL;
+
+	return (const float*)buffer->data + (frame * buffer->converter.channelsIn);
+}
+
+// Sums channels of source frames into a mono scratch, for the similarity search
+static void ReadStretchSourceMono(AudioBuffer* buffer, ma_int64 firstFrame, ma_uint32 frameCount, float* monoOut)
+{
+	const ma_uint32 channels = buffer->converter.channelsIn;
+	const bool looping = buffer->looping;
+	const ma_int64 size = (ma_int64)buffer->sizeInFrames;
+
+	ma_int64 source = WrapStretchSourceFrame(buffer, firstFrame);
+
+	for (ma_uint32 i = 0; i < frameCount; i++)
+	{
+		const float* frame = GetStretchSourceFrame(buffer, source);
+
+		float sum = 0.0f;
+		if (frame != NULL) for (ma_uint32 c = 0; c < channels; c++) sum += frame[c];
+
+		monoOut[i] = sum;
+
+		if ((++source == size) && looping) source = 0;
+	}
+}
+
+// Copies a source segment multiplied by the window
+static void ReadStretchSegment(TimeStretch* stretch, AudioBuffer* buffer, ma_int64 firstFrame)
+{
+	const ma_uint32 channels = stretch->channels;
+	const bool looping = buffer->looping;
+	const ma_int64 size = (ma_int64)buffer->sizeInFrames;
+
+	ma_int64 source = WrapStretchSourceFrame(buffer, firstFrame);
+
+	for (ma_uint32 i = 0; i < stretch->windowSize; i++)
+	{
+		const float* frame = GetStretchSourceFrame(buffer, source);
+		float* segmentFrame = stretch->segment + (i * channels);
+
+		if (frame != NULL) for (ma_uint32 c = 0; c < channels; c++) segmentFrame[c] = frame[c] * stretch->window[i];
+		else for (ma_uint32 c = 0; c < channels; c++) segmentFrame[c] = 0.0f;
+
+		if ((++source == size) && looping) source = 0;
+	}
+}
+
+// Restarts stretching at a source position, the previous segment is primed so the
+// first output hop comes out at full level
+static void ResetTimeStretch(TimeStretch* stretch, AudioBuffer* buffer, ma_uint32 position)
+{
+	stretch->timelinePos = position;
+	stretch->analysisPos = position;
+	stretch->previousPos = (double)position - stretch->hopSize;
+	stretch->outputPos = 0;
+	stretch->outputCount = 0;
+	stretch->expectedCursor = position;
+	stretch->expectedSize = buffer->sizeInFrames;
+
+	ReadStretchSegment(stretch, buffer, (ma_int64)stretch->previousPos);
+	memcpy(stretch->overlap, stretch->segment + (stretch->hopSize * stretch->channels), stretch->hopSize * stretch->channels * sizeof(float));
+}
+
+// Produces the next output hop: finds the segment around the ideal position that best continues
+// the previous one, then overlap-adds it
+static void ProcessTimeStretchHop(TimeStretch* stretch, AudioBuffer* buffer, float tempo)
+{
+	const ma_uint32 hopSize = stretch->hopSize;
+	const ma_uint32 searchRange = stretch->searchRange;
+	const ma_uint32 channels = stretch->channels;
+
+	ma_int64 idealPos = (ma_int64)floor(stretch->analysisPos);
+	ma_int64 naturalPos = (ma_int64)stretch->previousPos + hopSize;
+
+	// Normalized cross-correlation against the natural continuation of the previous segment
+	ReadStretchSourceMono(buffer, naturalPos, hopSize, stretch->monoNatural);
+	ReadStretchSourceMono(buffer, idealPos - searchRange, hopSize + 2 * searchRange, stretch->monoSearch);
+
+	float energy = DotProduct(stretch->monoSearch, stretch->monoSearch, hopSize);
+	float bestScore = -FLT_MAX;
+	ma_uint32 bestOffset = searchRange;
+
+	for (ma_uint32 offset = 0; offset <= 2 * searchRange; offset++)
+	{
+		const float* candidate = stretch->monoSearch + offset;
+
+		float score = DotProduct(candidate, stretch->monoNatural, hopSize) / sqrtf(energy + 1e-9f);
+		if (score > bestScore)
+		{
+			bestScore = score;
+			bestOffset = offset;
+		}
+
+		// Slide the candidate energy window
+		if (offset < 2 * searchRange) energy += candidate[hopSize] * candidate[hopSize] - candidate[0] * candidate[0];
+		if (energy < 0.0f) energy = 0.0f;
+	}
+
+	ma_int64 actualPos = idealPos - (ma_int64)searchRange + (ma_int64)bestOffset;
+
+	ReadStretchSegment(stretch, buffer, actualPos);
+
+	// First half overlaps the tail of the previous segment, second half is kept for the next hop
+	const ma_uint32 hopSamples = hopSize * channels;
+	for (ma_uint32 i = 0; i < hopSamples; i++) stretch->output[i] = stretch->overlap[i] + stretch->segment[i];
+	memcpy(stretch->overlap, stretch->segment + hopSamples, hopSamples * sizeof(float));
+
+	stretch->outputPos = 0;
+	stretch->outputCount = hopSize;
+	stretch->previousPos = (double)actualPos;
+	stretch->analysisPos += (double)hopSize * tempo;
+}
+
+// Reads time stretched frames from a static buffer, in internal format
+static ma_uint32 ReadAudioBufferFramesStretched(AudioBuffer* audioBuffer, float* framesOut, ma_uint32 frameCount)
+{
+	TimeStretch* stretch = audioBuffer->stretch;
+	const ma_uint32 channels = stretch->channels;
+	const double size = (double)audioBuffer->sizeInFrames;
+
+	// Cursor moved by someone else (play, stop, rebake), restart from there
+	if ((audioBuffer->frameCursorPos != stretch->expectedCursor) || (audioBuffer->sizeInFrames != stretch->expectedSize))
+	{
+		ResetTimeStretch(stretch, audioBuffer, audioBuffer->frameCursorPos);
+	}
+
+	ma_uint32 framesRead = 0;
+	bool finished = false;
+
+	while (framesRead < frameCount)
+	{
+		if (!audioBuffer->looping && (stretch->timelinePos >= size))
+		{
+			finished = true;
+			break;
+		}
+
+		if (stretch->outputPos >= stretch->outputCount) ProcessTimeStretchHop(stretch, audioBuffer, audioBuffer->tempo);
+
+		ma_uint32 framesToCopy = stretch->outputCount - stretch->outputPos;
+		if (framesToCopy > frameCount - framesRead) framesToCopy = frameCount - framesRead;
+
+		// Don't run past the end of non looping data
+		if (!audioBuffer->looping)
+		{
+			double framesLeft = ceil((size - stretch->timelinePos) / audioBuffer->tempo);
+			if ((double)framesToCopy > framesLeft) framesToCopy = (ma_uint32)framesLeft;
+		}
+
+		memcpy(framesOut + (framesRead * channels), stretch->output + (stretch->outputPos * channels), framesToCopy * channels * sizeof(float));
+
+		stretch->outputPos += framesToCopy;
+		stretch->timelinePos += (double)framesToCopy * audioBuffer->tempo;
+		if (audioBuffer->looping && (size > 0.0)) stretch->timelinePos = fmod(stretch->timelinePos, size);
+
+		framesRead += framesToCopy;
+	}
+
+	if (framesRead < frameCount) memset(framesOut + (framesRead * channels), 0, (frameCount - framesRead) * channels * sizeof(float));
+
+	if (finished)
+	{
+		StopAudioBuffer(audioBuffer);
+		return framesRead;
+	}
+
+	audioBuffer->frameCursorPos = (ma_uint32)stretch->timelinePos;
+	stretch->expectedCursor = audioBuffer->frameCursorPos;
+
+	return framesRead;
+}
+
+void SetAudioBufferTempo(AudioBuffer* buffer, float tempo)
+{
+	if ((buffer == NULL) || (tempo <= 0.0f)) return;
+
+	if (tempo < AUDIO_TEMPO_MIN) tempo = AUDIO_TEMPO_MIN;
+	else if (tempo > AUDIO_TEMPO_MAX) tempo = AUDIO_TEMPO_MAX;
+
+	// Only static float data can be stretched, that's what sounds are baked to
+	if ((buffer->usage != AUDIO_BUFFER_USAGE_STATIC) || (buffer->converter.formatIn != ma_format_f32)) return;
+
+	// Stretcher is installed beforehand by LoadAudioBufferTimeStretches(), never allocated with the mixing lock held
+	if ((buffer->stretch == NULL) && (tempo != 1.0f))
+	{
+		DEBUG_WARNING(unityLogPtr, "AUDIO: Time stretch not available, tempo ignored");
+		return;
+	}
+
+	// Coming back to stretching, state is stale, forces a reset on the next read
+	if ((buffer->stretch != NULL) && (buffer->tempo == 1.0f)) buffer->stretch->expectedSize = 0;
+
+	buffer->tempo = tempo;
+}
+
+// Installs stretchers on buffers a tempo command is about to change for the first time
+// NOTE: Buffers are looked up under the mixing lock, stretchers are allocated outside of it and installed under it again
+static void LoadAudioBufferTimeStretches(const AudioCommand* commands, unsigned int count)
+{
+	typedef struct PendingTimeStretch
+	{
+		unsigned int handle;
+		ma_uint32 channels;
+		ma_uint32 sampleRate;
+		TimeStretch* stretch;
+	} PendingTimeStretch;
+
+	std::vector<PendingTimeStretch> pending;
+	pending.reserve(count);
+
+	const bool locked = AUDIO.System.isReady;
+	if (locked) ma_mutex_lock(&AUDIO.System.lock);
+	{
+		for (unsigned int i = 0; i < count; i++)
+		{
+			if ((commands[i].type != AUDIO_COMMAND_SET_TEMPO) || (commands[i].value == 1.0f)) continue;
+
+			AudioBuffer* buffer = GetAudioBufferFromHandle(commands[i].handle);
+			if ((buffer == NULL) || (buffer->stretch != NULL)) continue;
+			if ((buffer->usage != AUDIO_BUFFER_USAGE_STATIC) || (buffer->converter.formatIn != ma_format_f32)) continue;
+
+			pending.push_back({ commands[i].handle, buffer->converter.channelsIn, buffer->sampleRate, NULL });
+		}
+	}
+	if (locked) ma_mutex_unlock(&AUDIO.System.lock);
+
+	if (pending.empty()) return;
+
+	for (PendingTimeStretch& entry : pending)
+	{
+		entry.stretch = LoadTimeStretch(entry.channels, entry.sampleRate);
+		if (entry.stretch == NULL) DEBUG_WARNING(unityLogPtr, "AUDIO: Failed to allocate memory for time stretch");
+	}
+
+	if (locked) ma_mutex_lock(&AUDIO.System.lock);
+	{
+		for (PendingTimeStretch& entry : pending)
+		{
+			AudioBuffer* buffer = GetAudioBufferFromHandle(entry.handle);
+
+			// Buffer could have been unloaded, rebaked or given a stretcher by another thread meanwhile
+			if ((buffer != NULL) && (buffer->stretch == NULL) && (entry.stretch != NULL) &&
+				(buffer->converter.channelsIn == entry.channels) && (buffer->sampleRate == entry.sampleRate))
+			{
+				buffer->stretch = entry.stretch;
+				entry.stretch = NULL;
+			}
+		}
+	}
+	if (locked) ma_mutex_unlock(&AUDIO.System.lock);
+
+	for (PendingTimeStretch& entry : pending) UnloadTimeStretch(entry.stretch);
+}
+
+void RiqSetSoundTempo(Sound sound, float tempo)
+{
+	if (sound.stream.buffer == NULL) return;
+
+	AudioCommand command = { 0 };
+	command.type = AUDIO_COMMAND_SET_TEMPO;
+	command.handle = sound.stream.buffer->handle;
+	command.value = tempo;
+
+	LoadAudioBufferTimeStretches(&command, 1);
+
+	const bool locked = AUDIO.System.isReady;
+	if (locked) ma_mutex_lock(&AUDIO.System.lock);
+	SetAudioBufferTempo(sound.stream.buffer, tempo);
+	if (locked) ma_mutex_unlock(&AUDIO.System.lock);
+}
+
+double RiqGetSoundSourcePosition(Sound sound)
+{
+	AudioBuffer* buffer = sound.stream.buffer;
+	if (buffer == NULL) return 0.0;
+
+	double position = 0.0;
+
+	const bool locked = AUDIO.System.isReady;
+	if (locked) ma_mutex_lock(&AUDIO.System.lock);
+	{
+		// Stretched playback keeps the exact (fractional) position, cursor would be truncated
+		if ((buffer->stretch != NULL) && (buffer->tempo != 1.0f) && (buffer->frameCursorPos == buffer->stretch->expectedCursor) && (buffer->sizeInFrames == buffer->stretch->expectedSize)) position = buffer->stretch->timelinePos;
+		else position = (double)buffer->frameCursorPos;
+
+		// Trimmed leading silence still counts, the play delay stands for it
+		if (buffer->silence.leadFrames > 0)
+		{
+			ma_uint32 leadDelay = GetAudioBufferLeadDelay(buffer);
+
+			if (buffer->silence.delayFrames > 0) position = (leadDelay > 0) ? (double)buffer->silence.leadFrames * (1.0 - (double)buffer->silence.delayFrames / leadDelay) : 0.0;
+			else position += buffer->silence.leadFrames;
+		}
+	}
+	if (locked) ma_mutex_unlock(&AUDIO.System.lock);
+
+	return position;
+}
+
+// ================================================================================
+#pragma endregion
+// ================================================================================
+
+// ================================================================================
+#pragma region rAudioFunctions
+// ================================================================================
+
+// Max mix levels of a buffer, a matrix of output x source channels
+#define AUDIO_MIX_MAX_LEVELS (AUDIO_RESAMPLER_MAX_CHANNELS*AUDIO_RESAMPLER_MAX_CHANNELS)
+
+// Get the up/downmix matrix of a buffer, levels[out*channelsIn + in], volume and pan included
+// NOTE: Mono and stereo sources are panned on front left/right and fed to center, LFE and surround speakers by the
+// AUDIO_UPMIX_* levels, mono outputs get the (L + R)/2 downmix. Sources matching the output channels map one to one
+static void GetAudioBufferMixLevels(const AudioBuffer* buffer, ma_uint32 channelsIn, ma_uint32 channelsOut, float* levels)
+{
+	const float localVolume = buffer->volume;
+
+	memset(levels, 0, (size_t)channelsIn * channelsOut * sizeof(float));
+
+	if ((channelsIn > 2) || (GetChannelLayoutIndex(channelsOut) < 0))
+	{
+		if (channelsIn == channelsOut) for (ma_uint32 c = 0; c < channelsOut; c++) levels[c * channelsIn + c] = localVolume;
+		return;
+	}
+
+	// Stereo source matrix first, a mono source feeds both of its columns
+	float matrix[AUDIO_LAYOUT_SURROUND_7_1][2] = { 0 };
+
+	if (channelsOut == AUDIO_LAYOUT_MONO)
+	{
+		matrix[0][0] = 0.5f * localVolume;
+		matrix[0][1] = 0.5f * localVolume;
+	}
+	else
+	{
+		const float left = buffer->pan;
+		const float right = 1.0f - left;
+
+		// Fast sine approximation in [0..1] for pan law: y = 0.5f*x*(3 - x*x);
+		const float levelLeft = localVolume * 0.5f * left * (3.0f - left * left);
+		const float levelRight = localVolume * 0.5f * right * (3.0f - right * right);
+
+		matrix[0][0] = levelLeft;
+		matrix[1][1] = levelRight;
+
+		if (channelsOut >= AUDIO_LAYOUT_SURROUND_5_1)
+		{
+			// Speakers after FL, FR: FC, LFE, BL, BR (5.1) then SL, SR (7.1)
+			const float surround = (channelsOut == AUDIO_LAYOUT_SURROUND_7_1) ? AUDIO_UPMIX_SURROUND_LEVEL * 0.70710678f : AUDIO_UPMIX_SURROUND_LEVEL;
+
+			matrix[2][0] = AUDIO_UPMIX_CENTER_LEVEL * levelLeft;
+			matrix[2][1] = AUDIO_UPMIX_CENTER_LEVEL * levelRight;
+			matrix[3][0] = AUDIO_UPMIX_LFE_LEVEL * levelLeft;
+			matrix[3][1] = AUDIO_UPMIX_LFE_LEVEL * levelRight;
+
+			for (ma_uint32 c = 4; c < channelsOut; c += 2)
+			{
+				matrix[c][0] = surround * levelLeft;
+				matrix[c + 1][1] = surround * levelRight;
+			}
+		}
+	}
+
+	for (ma_uint32 c = 0; c < channelsOut; c++)
 	{
-		if (AUDIO.Buffer.first == NULL) AUDIO.Buffer.first = buffer;
+		if (channelsIn == 1) levels[c] = matrix[c][0] + matrix[c][1];
 		else
 		{
-			AUDIO.Buffer.last->next = buffer;
-			buffer->prev = AUDIO.Buffer.last;
+			levels[c * 2] = matrix[c][0];
+			levels[c * 2 + 1] = matrix[c][1];
 		}
-
-		AUDIO.Buffer.last = buffer;
 	}
-	ma_mutex_unlock(&AUDIO.System.lock);
 }
 
-void UntrackAudioBuffer(AudioBuffer* buffer)
+// Mix kernel for a source x output channels pair, the matrix size is resolved at compile time
+template <int InChannels, int OutChannels>
+static void MixFramesKernel(float* framesOut, const float* framesIn, ma_uint32 frameCount, const float* levels)
 {
-	ma_mutex_lock(&AUDIO.System.lock);
-	{
-		if (buffer->prev == NULL) AUDIO.Buffer.first = buffer->next;
-		else buffer->prev->next = buffer->next;
+	static_assert((InChannels == 1) || (InChannels == 2), "Mix sources are mono or stereo");
+
+	ma_uint32 frame = 0;
 
-		if (buffer->next == NULL) AUDIO.Buffer.last = buffer->prev;
-		else buffer->next->prev = buffer->prev;
+#if defined(RIQ_SIMD_SSE2)
+	if constexpr ((InChannels == 2) && (OutChannels == 2))
+	{
+		// Two stereo frames per register, stereo to stereo has no cross feeds
+		const __m128 levelsPair = _mm_setr_ps(levels[0], levels[3], levels[0], levels[3]);
 
-		buffer->prev = NULL;
-		buffer->next = NULL;
+		for (; frame + 2 <= frameCount; frame += 2)
+		{
+			__m128 out = _mm_loadu_ps(framesOut + (frame * 2));
+			_mm_storeu_ps(framesOut + (frame * 2), _mm_add_ps(out, _mm_mul_ps(_mm_loadu_ps(framesIn + (frame * 2)), levelsPair)));
+		}
 	}
-	ma_mutex_unlock(&AUDIO.System.lock);
-}
+#endif
 
-// ================================================================================
-#pragma endregion
-// ================================================================================
+	for (; frame < frameCount; frame++)
+	{
+		float* frameOut = framesOut + (frame * OutChannels);
+		const float* frameIn = framesIn + (frame * InChannels);
 
-// ================================================================================
-#pragma region Sound
-// ================================================================================
+		for (int c = 0; c < OutChannels; c++)
+		{
+			float sample = frameIn[0] * levels[c * InChannels];
+			if constexpr (InChannels == 2) sample += frameIn[1] * levels[c * InChannels + 1];
 
-Sound RiqLoadSound(const char* filePath)
-{
-	Wave wave = RiqLoadWave(filePath);
+			frameOut[c] += sample;
+		}
+	}
+}
 
-	Sound sound = RiqLoadSoundFromWave(wave);
+typedef void (*MixFramesFunc)(float* framesOut, const float* framesIn, ma_uint32 frameCount, const float* levels);
 
-	RiqUnloadWave(wave);
+// Kernels by source channels (mono, stereo) and output layout (mono, stereo, 5.1, 7.1)
+static const MixFramesFunc mixFramesKernels[2][4] = {
+	{ MixFramesKernel<1, 1>, MixFramesKernel<1, 2>, MixFramesKernel<1, 6>, MixFramesKernel<1, 8> },
+	{ MixFramesKernel<2, 1>, MixFramesKernel<2, 2>, MixFramesKernel<2, 6>, MixFramesKernel<2, 8> },
+};
 
-	return sound;
+static int GetChannelLayoutIndex(ma_uint32 channels)
+{
+	switch (channels)
+	{
+		case AUDIO_LAYOUT_MONO: return 0;
+		case AUDIO_LAYOUT_STEREO: return 1;
+		case AUDIO_LAYOUT_SURROUND_5_1: return 2;
+		case AUDIO_LAYOUT_SURROUND_7_1: return 3;
+		default: return -1;
+	}
 }
 
-
-Sound RiqLoadSoundFromWave(Wave wave)
+// Main mixing function, pretty simple in this project, just an accumulation
+// NOTE: framesOut is both an input and an output, it is initially filled with zeros outside of this function
+static void MixAudioFrames(float* framesOut, const float* framesIn, ma_uint32 frameCount, ma_uint32 channelsIn, AudioBuffer* buffer)
 {
-	Sound sound = { 0 };
-
-	if (wave.data != NULL)
-	{
-		// When using miniaudio we need to do our own mixing.
-		// To simplify this we need convert the format of each sound to be consistent with
-		// the format used to open the playback AUDIO.System.device. We can do this two ways:
-		//
-		//   1) Convert the whole sound in one go at load time (here).
-		//   2) Convert the audio data in chunks at mixing time.
-		//
-		// First option has been selected, format conversion is done on the loading stage.
-		// The downside is that it uses more memory if the original sound is u8 or s16.
-		ma_format formatIn = ((wave.sampleSize == 8) ? ma_format_u8 : ((wave.sampleSize == 16) ? ma_format_s16 : ma_format_f32));
-		ma_uint32 frameCountIn = wave.frameCount;
+	const ma_uint32 channels = AUDIO.System.device.playback.channels;
+	const int layout = GetChannelLayoutIndex(channels);
 
-		ma_uint32 frameCount = (ma_uint32)ma_convert_frames(NULL, 0, AUDIO_DEVICE_FORMAT, AUDIO_DEVICE_CHANNELS, AUDIO.System.device.sampleRate, NULL, frameCountIn, formatIn, wave.channels, wave.sampleRate);
-		if (frameCount == 0) DEBUG_WARNING(unityLogPtr, "SOUND: Failed to get frame count for format conversion");
+	float levels[AUDIO_MIX_MAX_LEVELS];
+	GetAudioBufferMixLevels(buffer, channelsIn, channels, levels);
 
-		AudioBuffer* audioBuffer = LoadAudioBuffer(AUDIO_DEVICE_FORMAT, AUDIO_DEVICE_CHANNELS, AUDIO.System.device.sampleRate, frameCount, AUDIO_BUFFER_USAGE_STATIC);
-		if (audioBuffer == NULL)
+	if ((layout >= 0) && ((channelsIn == 1) || (channelsIn == 2)))
+	{
+		mixFramesKernels[channelsIn - 1][layout](framesOut, framesIn, frameCount, levels);
+	}
+	else if (channelsIn == channels)  // Any other layout, channels map one to one, no panning
+	{
+		for (ma_uint32 frame = 0; frame < frameCount; frame++)
 		{
-			DEBUG_WARNING(unityLogPtr, "SOUND: Failed to create buffer");
-			return sound; // Early return to avoid dereferencing the audioBuffer null pointer.
-		}
-
-		frameCount = (ma_uint32)ma_convert_frames(audioBuffer->data, frameCount, AUDIO_DEVICE_FORMAT, AUDIO_DEVICE_CHANNELS, AUDIO.System.device.sampleRate, wave.data, frameCountIn, formatIn, wave.channels, wave.sampleRate);
-		if (frameCount == 0) DEBUG_WARNING(unityLogPtr, "SOUND: Failed format conversion");
+			for (ma_uint32 c = 0; c < channels; c++)
+			{
+				float* frameOut = framesOut + (frame * channels);
+				const float* frameIn = framesIn + (frame * channels);
 
-		sound.frameCount = frameCount;
-		sound.stream.sampleRate = AUDIO.System.device.sampleRate;
-		sound.stream.sampleSize = 32;
-		sound.stream.channels = AUDIO_DEVICE_CHANNELS;
-		sound.stream.buffer = audioBuffer;
+				// Output accumulates input multiplied by volume to provided output (usually 0)
+				frameOut[c] += (frameIn[c] * levels[c * channels + c]);
+			}
+		}
 	}
-
-	return sound;
 }
 
-void RiqUnloadSound(Sound sound)
+// Check if a buffer can skip the data converter and go through the direct resampler
+static bool IsAudioBufferResampledDirectly(const AudioBuffer* buffer)
 {
-	UnloadAudioBuffer(sound.stream.buffer);
+	if (buffer->resampler == AUDIO_RESAMPLER_CONVERTER) return false;
+	if ((buffer->callback != NULL) || (buffer->usage != AUDIO_BUFFER_USAGE_STATIC)) return false;
+	if ((buffer->stretch != NULL) && (buffer->tempo != 1.0f)) return false;
+	if ((buffer->converter.formatIn != ma_format_f32) || (buffer->converter.channelsIn != buffer->converter.channelsOut)) return false;
+	if (buffer->converter.channelsIn > AUDIO_RESAMPLER_MAX_CHANNELS) return false;
+	if ((buffer->sizeInFrames == 0) || (buffer->data == NULL)) return false;
+
+	return true;
 }
 
-
-void RiqPlaySound(Sound sound)
+// Get a frame for interpolation, out of bounds frames wrap when looping or read as silence
+static const float* GetResamplerFrame(const AudioBuffer* buffer, ma_int64 frame, const float* silence)
 {
-	PlayAudioBuffer(sound.stream.buffer);
-}
+	const ma_int64 size = (ma_int64)buffer->sizeInFrames;
 
-// ================================================================================
-#pragma endregion
-// ================================================================================
+	if (buffer->looping)
+	{
+		frame %= size;
+		if (frame < 0) frame += size;
+	}
+	else if ((frame < 0) || (frame >= size)) return silence;
 
-// ================================================================================
-#pragma region Wave
-// ================================================================================
+	return (const float*)buffer->data + (frame * buffer->converter.channelsIn);
+}
 
-Wave RiqLoadWave(const char* filePath)
+// Resamples a static buffer straight from its data with a 32.32 fixed point phase and
+// accumulates the result multiplied by levels into framesOut, returns frames produced
+// NOTE: Interpolation, volume and pan are fused in a single pass, stereo interior frames go two at a time in SIMD
+static ma_uint32 MixAudioBufferResampled(AudioBuffer* buffer, float* framesOut, ma_uint32 frameCount, const float* levels)
 {
-	Wave wave = { 0 };
+	const ma_uint32 channels = buffer->converter.channelsIn;
+	const ma_uint64 size = buffer->sizeInFrames;
+	const float* data = (const float*)buffer->data;
+	const bool cubic = (buffer->resampler == AUDIO_RESAMPLER_CUBIC);
 
-	unsigned int fileSize = 0;
-	unsigned char* fileData = LoadFileData(filePath, &fileSize);
+	// Source frames advanced per output frame, in 32.32 fixed point
+	const double ratio = ((double)buffer->sampleRate / (double)AUDIO.System.device.sampleRate) * (double)buffer->pitch;
+	const ma_uint64 step = (ma_uint64)(ratio * 4294967296.0);
 
-	if (fileData != NULL) wave = RiqLoadWaveFromMemory(GetFileExtension(filePath), fileData, fileSize);
+	const float silence[AUDIO_RESAMPLER_MAX_CHANNELS] = { 0 };
 
-	RIQ_FREE(fileData);
+	ma_uint64 position = ((ma_uint64)buffer->frameCursorPos << 32) | buffer->resamplePhase;
+	ma_uint32 framesDone = 0;
+	bool finished = false;
 
-	return wave;
-}
+	// Silent spans are skipped, frames whose taps all lie in one just leave the output untouched
+	const SilenceSpan* spans = buffer->silence.spans;
+	const unsigned int spanCount = buffer->silence.spanCount;
+	unsigned int span = (spanCount > 0) ? FindSilenceSpan(buffer, buffer->frameCursorPos) : 0;
 
-Wave RiqLoadWaveFromMemory(const char* fileType, const unsigned char* fileData, int dataSize)
-{
-	Wave wave = { 0 };
+#if defined(RIQ_SIMD_SSE2)
+	const __m128 levelsPair = _mm_setr_ps(levels[0], (channels == 2) ? levels[1] : 0.0f, levels[0], (channels == 2) ? levels[1] : 0.0f);
+#endif
 
-	if (false) {}
-#if defined(SUPPORT_FILEFORMAT_WAV)
-	else if (strcmp(fileType, ".wav") == 0)
+	while (framesDone < frameCount)
 	{
-		drwav wav = { 0 };
-		bool success = drwav_init_memory(&wav, fileData, dataSize, NULL);
+		ma_uint64 index = position >> 32;
 
-		if (success)
+		if (index >= size)
 		{
-			wave.frameCount = (unsigned int)wav.totalPCMFrameCount;
-			wave.sampleRate = wav.sampleRate;
-			wave.sampleSize = 16;
-			wave.channels = wav.channels;
-			wave.data = (short*)RIQ_MALLOC(wave.frameCount * wave.channels * sizeof(short));
+			if (!buffer->looping)
+			{
+				finished = true;
+				break;
+			}
 
-			// NOTE: We are forcing conversion to 16bit sample size on reading
-			drwav_read_pcm_frames_s16(&wav, wav.totalPCMFrameCount, (drwav_int16*)wave.data);
+			index %= size;
+			position = (index << 32) | (position & 0xFFFFFFFF);
+			span = (spanCount > 0) ? FindSilenceSpan(buffer, index) : 0;
 		}
-		else DEBUG_WARNING(unityLogPtr, "WAVE: Failed to load WAV data!");
-
-		drwav_uninit(&wav);
-	}
-#endif
-#if defined(SUPPORT_FILEFORMAT_OGG)
-	else if (strcmp(fileType, ".ogg") == 0)
-	{
-		stb_vorbis* oggData = stb_vorbis_open_memory((unsigned char*)fileData, dataSize, NULL, NULL);
 
-		if (oggData != NULL)
+		if (span < spanCount)
 		{
-			stb_vorbis_info info = stb_vorbis_get_info(oggData);
-
-			wave.sampleRate = info.sample_rate;
-			wave.sampleSize = 16;
-			wave.channels = info.channels;
-			wave.frameCount = (unsigned int)stb_vorbis_stream_length_in_samples(oggData);
-			wave.data = (short*)RIQ_MALLOC(wave.frameCount * wave.channels * sizeof(short));
+			while ((span < spanCount) && (index >= (ma_uint64)spans[span].start + spans[span].length)) span++;
 
-			stb_vorbis_get_samples_short_interleaved(oggData, info.channels, (short*)wave.data, wave.frameCount * wave.channels);
-			stb_vorbis_close(oggData);
+			if ((span < spanCount) && (index >= (ma_uint64)spans[span].start + 1) && (index + 2 < (ma_uint64)spans[span].start + spans[span].length))
+			{
+				// Skip every output frame up to the first one with a tap past the span
+				const ma_uint64 spanEnd = ((ma_uint64)spans[span].start + spans[span].length - 2) << 32;
+				ma_uint64 skipFrames = (spanEnd - position + step - 1) / step;
+				if (skipFrames > (frameCount - framesDone)) skipFrames = frameCount - framesDone;
+
+				position += skipFrames * step;
+				framesDone += (ma_uint32)skipFrames;
+				continue;
+			}
 		}
-		else DEBUG_WARNING(unityLogPtr, "WAVE: Failed to load OGG data!");
-	}
-#endif
-	else DEBUG_WARNING(unityLogPtr, "WAVE: Data format not supported!");
 
-	DEBUG_LOG_FMT(unityLogPtr, "WAVE: Data loaded successfully (%i Hz, %i bit, %i channels)", wave.sampleRate, wave.sampleSize, wave.channels);
+#if defined(RIQ_SIMD_SSE2)
+		// Two stereo frames at once, as long as every tap of both is inside the data
+		if ((channels == 2) && (framesDone + 2 <= frameCount))
+		{
+			const ma_uint64 positionB = position + step;
+			const ma_uint64 indexB = positionB >> 32;
 
-	return wave;
-}
+			if ((index >= 1) && (indexB + 2 < size))
+			{
+				const float fracA = (float)(position & 0xFFFFFFFF) * (1.0f / 4294967296.0f);
+				const float fracB = (float)(positionB & 0xFFFFFFFF) * (1.0f / 4294967296.0f);
+				const __m128 frac = _mm_setr_ps(fracA, fracA, fracB, fracB);
 
-void RiqUnloadWave(Wave wave)
-{
-	RIQ_FREE(wave.data);
-}
+				const float* tapA = data + (index * 2);
+				const float* tapB = data + (indexB * 2);
 
-// ================================================================================
-#pragma endregion
-// ================================================================================
+				__m128 x0 = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64*)tapA), (const __m64*)tapB);
+				__m128 x1 = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64*)(tapA + 2)), (const __m64*)(tapB + 2));
+				__m128 y;
 
-// ================================================================================
-#pragma region rAudioFunctions
-// ================================================================================
+				if (cubic)
+				{
+					__m128 xm1 = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64*)(tapA - 2)), (const __m64*)(tapB - 2));
+					__m128 x2 = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64*)(tapA + 4)), (const __m64*)(tapB + 4));
 
-// Main mixing function, pretty simple in this project, just an accumulation
-// NOTE: framesOut is both an input and an output, it is initially filled with zeros outside of this function
-static void MixAudioFrames(float* framesOut, const float* framesIn, ma_uint32 frameCount, AudioBuffer* buffer)
-{
-	const float localVolume = buffer->volume;
-	const ma_uint32 channels = AUDIO.System.device.playback.channels;
+					// 4-point Catmull-Rom
+					__m128 c1 = _mm_mul_ps(_mm_set1_ps(0.5f), _mm_sub_ps(x1, xm1));
+					__m128 c2 = _mm_sub_ps(_mm_add_ps(xm1, _mm_mul_ps(_mm_set1_ps(2.0f), x1)), _mm_add_ps(_mm_mul_ps(_mm_set1_ps(2.5f), x0), _mm_mul_ps(_mm_set1_ps(0.5f), x2)));
+					__m128 c3 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(0.5f), _mm_sub_ps(x2, xm1)), _mm_mul_ps(_mm_set1_ps(1.5f), _mm_sub_ps(x0, x1)));
 
-	if (channels == 2)  // We consider panning
-	{
-		const float left = buffer->pan;
-		const float right = 1.0f - left;
+					y = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(c3, frac), c2), frac), c1), frac), x0);
+				}
+				else y = _mm_add_ps(x0, _mm_mul_ps(_mm_sub_ps(x1, x0), frac));
 
-		// Fast sine approximation in [0..1] for pan law: y = 0.5f*x*(3 - x*x);
-		const float levels[2] = { localVolume * 0.5f * left * (3.0f - left * left), localVolume * 0.5f * right * (3.0f - right * right) };
+				float* out = framesOut + (framesDone * 2);
+				_mm_storeu_ps(out, _mm_add_ps(_mm_loadu_ps(out), _mm_mul_ps(y, levelsPair)));
 
-		float* frameOut = framesOut;
-		const float* frameIn = framesIn;
+				position = positionB + step;
+				framesDone += 2;
+				continue;
+			}
+		}
+#endif
 
-		for (ma_uint32 frame = 0; frame < frameCount; frame++)
-		{
-			frameOut[0] += (frameIn[0] * levels[0]);
-			frameOut[1] += (frameIn[1] * levels[1]);
+		// One frame at a time, around the data edges or for other layouts
+		const float frac = (float)(position & 0xFFFFFFFF) * (1.0f / 4294967296.0f);
+		const float* x0 = GetResamplerFrame(buffer, (ma_int64)index, silence);
+		const float* x1 = GetResamplerFrame(buffer, (ma_int64)index + 1, silence);
+		float* out = framesOut + (framesDone * channels);
 
-			frameOut += 2;
-			frameIn += 2;
-		}
-	}
-	else  // We do not consider panning
-	{
-		for (ma_uint32 frame = 0; frame < frameCount; frame++)
+		if (cubic)
 		{
+			const float* xm1 = GetResamplerFrame(buffer, (ma_int64)index - 1, silence);
+			const float* x2 = GetResamplerFrame(buffer, (ma_int64)index + 2, silence);
+
 			for (ma_uint32 c = 0; c < channels; c++)
 			{
-				float* frameOut = framesOut + (frame * channels);
-				const float* frameIn = framesIn + (frame * channels);
+				float c1 = 0.5f * (x1[c] - xm1[c]);
+				float c2 = xm1[c] - 2.5f * x0[c] + 2.0f * x1[c] - 0.5f * x2[c];
+				float c3 = 0.5f * (x2[c] - xm1[c]) + 1.5f * (x0[c] - x1[c]);
 
-				// Output accumulates input multiplied by volume to provided output (usually 0)
-				frameOut[c] += (frameIn[c] * localVolume);
+				out[c] += ((((c3 * frac) + c2) * frac + c1) * frac + x0[c]) * levels[c];
 			}
 		}
+		else for (ma_uint32 c = 0; c < channels; c++) out[c] += (x0[c] + (x1[c] - x0[c]) * frac) * levels[c];
+
+		position += step;
+		framesDone++;
+	}
+
+	if (finished)
+	{
+		StopAudioBuffer(buffer);
+		buffer->resamplePhase = 0;
+	}
+	else
+	{
+		ma_uint64 index = position >> 32;
+		if (buffer->looping && (index >= size)) index %= size;
+
+		buffer->frameCursorPos = (ma_uint32)index;
+		buffer->resamplePhase = (ma_uint32)(position & 0xFFFFFFFF);
 	}
+
+	return framesDone;
+}
+
+void SetAudioBufferResampler(AudioBuffer* buffer, int resampler)
+{
+	if ((buffer == NULL) || (resampler < AUDIO_RESAMPLER_CONVERTER) || (resampler > AUDIO_RESAMPLER_CUBIC)) return;
+
+	buffer->resampler = resampler;
+}
+
+void RiqSetSoundResampler(Sound sound, int resampler)
+{
+	const bool locked = AUDIO.System.isReady;
+	if (locked) ma_mutex_lock(&AUDIO.System.lock);
+	SetAudioBufferResampler(sound.stream.buffer, resampler);
+	if (locked) ma_mutex_unlock(&AUDIO.System.lock);
 }
 
 // Reads audio data from an AudioBuffer object in internal format.
@@ -493,6 +4351,12 @@ static ma_uint32 ReadAudioBufferFramesInInternalFormat(AudioBuffer* audioBuffer,
 		return frameCount;
 	}
 
+	// Using time stretch, tempo change without pitch change
+	if ((audioBuffer->stretch != NULL) && (audioBuffer->tempo != 1.0f))
+	{
+		return ReadAudioBufferFramesStretched(audioBuffer, (float*)framesOut, frameCount);
+	}
+
 	ma_uint32 subBufferSizeInFrames = (audioBuffer->sizeInFrames > 1) ? audioBuffer->sizeInFrames / 2 : audioBuffer->sizeInFrames;
 	ma_uint32 currentSubBufferIndex = audioBuffer->frameCursorPos / subBufferSizeInFrames;
 
@@ -626,6 +4490,12 @@ static void OnSendAudioDataToDevice(ma_device* pDevice, void* pFramesOut, const
 {
 	(void)pDevice;
 
+	const std::chrono::steady_clock::time_point callbackStart = std::chrono::steady_clock::now();
+	unsigned int buffersMixed = 0;
+
+	// Processor chains loaded from here on are protected from being freed until the epoch moves again
+	AUDIO.System.callbackEpoch.fetch_add(1);
+
 	// Mixing is basically just an accumulation, we need to initialize the output buffer to 0
 	memset(pFramesOut, 0, frameCount * pDevice->playback.channels * ma_get_bytes_per_sample(pDevice->playback.format));
 
@@ -633,34 +4503,112 @@ static void OnSendAudioDataToDevice(ma_device* pDevice, void* pFramesOut, const
 	// This is unlikely to be necessary for this project, but may want to consider how you might want to avoid this
 	ma_mutex_lock(&AUDIO.System.lock);
 	{
+		// Unloaded buffers leave the list before anything is mixed, their effects may already be gone
+		UnlinkUnloadedAudioBuffers();
+
 		for (AudioBuffer* audioBuffer = AUDIO.Buffer.first; audioBuffer != NULL; audioBuffer = audioBuffer->next)
 		{
 			// Ignore stopped or paused sounds
 			if (!audioBuffer->playing || audioBuffer->paused) continue;
 
+			buffersMixed++;
+
+			float* mixOut = (float*)pFramesOut;
+			ma_uint32 mixFrameCount = frameCount;
+
+			// Trimmed leading silence plays as a delay
+			if (audioBuffer->silence.delayFrames > 0)
+			{
+				ma_uint32 delayFrames = (audioBuffer->silence.delayFrames < frameCount) ? audioBuffer->silence.delayFrames : frameCount;
+				audioBuffer->silence.delayFrames -= delayFrames;
+
+				mixOut += delayFrames * AUDIO.System.device.playback.channels;
+				mixFrameCount -= delayFrames;
+
+				if (mixFrameCount == 0) continue;
+			}
+
+			// Static float data resamples straight from its data, skipping the data converter
+			if (IsAudioBufferResampledDirectly(audioBuffer))
+			{
+				const ma_uint32 channels = audioBuffer->converter.channelsOut;
+				AudioProcessorChain* chain = audioBuffer->processorChain.load();
+
+				AudioMeter* meter = audioBuffer->meter.load();
+
+				if ((audioBuffer->processor == NULL) && (chain == NULL) && (meter == NULL) && (channels == AUDIO.System.device.playback.channels))
+				{
+					// Fused with volume and pan, straight into the output. Source and output channels match,
+					// so the matrix is diagonal and every channel takes its own level
+					float matrix[AUDIO_MIX_MAX_LEVELS];
+					GetAudioBufferMixLevels(audioBuffer, channels, channels, matrix);
+
+					float levels[AUDIO_RESAMPLER_MAX_CHANNELS] = { 0 };
+					for (ma_uint32 c = 0; c < channels; c++) levels[c] = matrix[c * channels + c];
+
+					MixAudioBufferResampled(audioBuffer, mixOut, mixFrameCount, levels);
+				}
+				else
+				{
+					// Processors need the frames on their own, resampled in blocks at unity level
+					const float unity[AUDIO_RESAMPLER_MAX_CHANNELS] = { 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f };
+					float tempBuffer[1024];
+
+					ma_uint32 blockFrames = (ma_uint32)(sizeof(tempBuffer) / sizeof(tempBuffer[0])) / channels;
+					ma_uint32 framesRead = 0;
+
+					while ((framesRead < mixFrameCount) && audioBuffer->playing)
+					{
+						ma_uint32 framesToRead = mixFrameCount - framesRead;
+						if (framesToRead > blockFrames) framesToRead = blockFrames;
+
+						memset(tempBuffer, 0, framesToRead * channels * sizeof(float));
+						ma_uint32 framesJustRead = MixAudioBufferResampled(audioBuffer, tempBuffer, framesToRead, unity);
+						if (framesJustRead == 0) break;
+
+						riqAudioProcessor* processor = audioBuffer->processor;
+						while (processor)
+						{
+							processor->process(tempBuffer, framesJustRead);
+							processor = processor->next;
+						}
+
+						if (chain != NULL) ProcessAudioProcessorChain(chain, tempBuffer, framesJustRead, channels);
+						if (meter != NULL) UpdateAudioMeter(meter, tempBuffer, framesJustRead, channels, audioBuffer->volume);
+
+						MixAudioFrames(mixOut + (framesRead * AUDIO.System.device.playback.channels), tempBuffer, framesJustRead, channels, audioBuffer);
+						framesRead += framesJustRead;
+					}
+				}
+
+				continue;
+			}
+
 			ma_uint32 framesRead = 0;
 
 			while (1)
 			{
-				if (framesRead >= frameCount) break;
+				if (framesRead >= mixFrameCount) break;
 
 				// Just read as much data as we can from the stream
-				ma_uint32 framesToRead = (frameCount - framesRead);
+				ma_uint32 framesToRead = (mixFrameCount - framesRead);
 
 				while (framesToRead > 0)
 				{
-					float tempBuffer[1024] = { 0 }; // Frames for stereo
+					float tempBuffer[1024] = { 0 }; // Frames in the sound data channels
+
+					const ma_uint32 channelsIn = audioBuffer->converter.channelsOut;
 
 					ma_uint32 framesToReadRightNow = framesToRead;
-					if (framesToReadRightNow > sizeof(tempBuffer) / sizeof(tempBuffer[0]) / AUDIO_DEVICE_CHANNELS)
+					if (framesToReadRightNow > sizeof(tempBuffer) / sizeof(tempBuffer[0]) / channelsIn)
 					{
-						framesToReadRightNow = sizeof(tempBuffer) / sizeof(tempBuffer[0]) / AUDIO_DEVICE_CHANNELS;
+						framesToReadRightNow = sizeof(tempBuffer) / sizeof(tempBuffer[0]) / channelsIn;
 					}
 
 					ma_uint32 framesJustRead = ReadAudioBufferFramesInMixingFormat(audioBuffer, tempBuffer, framesToReadRightNow);
 					if (framesJustRead > 0)
 					{
-						float* framesOut = (float*)pFramesOut + (framesRead * AUDIO.System.device.playback.channels);
+						float* framesOut = mixOut + (framesRead * AUDIO.System.device.playback.channels);
 						float* framesIn = tempBuffer;
 
 						// Apply processors chain if defined
@@ -671,7 +4619,13 @@ static void OnSendAudioDataToDevice(ma_device* pDevice, void* pFramesOut, const
 							processor = processor->next;
 						}
 
-						MixAudioFrames(framesOut, framesIn, framesJustRead, audioBuffer);
+						AudioProcessorChain* chain = audioBuffer->processorChain.load();
+						if (chain != NULL) ProcessAudioProcessorChain(chain, framesIn, framesJustRead, channelsIn);
+
+						AudioMeter* meter = audioBuffer->meter.load();
+						if (meter != NULL) UpdateAudioMeter(meter, framesIn, framesJustRead, channelsIn, audioBuffer->volume);
+
+						MixAudioFrames(framesOut, framesIn, framesJustRead, channelsIn, audioBuffer);
 
 						framesToRead -= framesJustRead;
 						framesRead += framesJustRead;
@@ -679,7 +4633,7 @@ static void OnSendAudioDataToDevice(ma_device* pDevice, void* pFramesOut, const
 
 					if (!audioBuffer->playing)
 					{
-						framesRead = frameCount;
+						framesRead = mixFrameCount;
 						break;
 					}
 
@@ -715,7 +4669,31 @@ static void OnSendAudioDataToDevice(ma_device* pDevice, void* pFramesOut, const
 		processor = processor->next;
 	}
 
+	AudioProcessorChain* chain = AUDIO.mixedProcessorChain.load();
+	if (chain != NULL) ProcessAudioProcessorChain(chain, (float*)pFramesOut, frameCount, pDevice->playback.channels);
+
+	if (AUDIO.Calibration.active.load()) ProcessLatencyCalibration((float*)pFramesOut, (const float*)pFramesInput, frameCount, pDevice->playback.channels);
+
+	UpdateAudioMeter(&AUDIO.Meter, (const float*)pFramesOut, frameCount, pDevice->playback.channels, 1.0f);
+	if (AUDIO.Spectrum.enabled) FeedAudioSpectrum((const float*)pFramesOut, frameCount, pDevice->playback.channels);
+
+	// Callback time is taken from entry, time spent waiting for the lock counts too
+	ma_uint64 callbackNs = (ma_uint64)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - callbackStart).count();
+	float load = (frameCount > 0) ? (float)((double)callbackNs * pDevice->sampleRate / ((double)frameCount * 1000000000.0)) : 0.0f;
+
+	AUDIO.Stats.callbackCount++;
+	AUDIO.Stats.framesMixed += frameCount;
+	AUDIO.Stats.totalNs += callbackNs;
+	AUDIO.Stats.lastNs = callbackNs;
+	if (callbackNs > AUDIO.Stats.worstNs) AUDIO.Stats.worstNs = callbackNs;
+	AUDIO.Stats.buffersMixed = buffersMixed;
+	if (buffersMixed > AUDIO.Stats.maxBuffersMixed) AUDIO.Stats.maxBuffersMixed = buffersMixed;
+	if (load > 1.0f) AUDIO.Stats.overruns++;
+	if (load > AUDIO.Stats.worstLoad) AUDIO.Stats.worstLoad = load;
+
 	ma_mutex_unlock(&AUDIO.System.lock);
+
+	AUDIO.System.callbackEpoch.fetch_add(1);
 }
 
 // Get pointer to extension for a filename string (includes the dot: .png)
@@ -750,8 +4728,7 @@ static unsigned char* LoadFileData(const char* fileName, unsigned int* bytesRead
 			{
 				data = (unsigned char*)RIQ_MALLOC(size * sizeof(unsigned char));
 
-				// Data is always greater than 0, but this got rid of an annoying warning.
-				if (data > 0)
+				if (data != NULL)
 				{
 					// NOTE: fread() returns number of read elements instead of bytes, so we read [1 byte, size elements]
 					unsigned int count = (unsigned int)fread(data, sizeof(unsigned char), size, file);
@@ -4,6 +4,8 @@
 
 #include "miniaudio/miniaudio.h"
 
+#include <atomic>
+
 // ================================================================================
 #pragma region Defines and Macros
 // ================================================================================
@@ -12,7 +14,7 @@
 #define AUDIO_DEVICE_FORMAT    ma_format_f32    // Device output format (float-32bit)
 #endif
 #ifndef AUDIO_DEVICE_CHANNELS
-#define AUDIO_DEVICE_CHANNELS              2    // Device output channels: stereo
+#define AUDIO_DEVICE_CHANNELS              2    // Sound data and mix source channels: stereo, output layout is chosen at init
 #endif
 #ifndef AUDIO_DEVICE_SAMPLE_RATE
 #define AUDIO_DEVICE_SAMPLE_RATE           0    // Device output sample rate
@@ -22,6 +24,91 @@
 #define MAX_AUDIO_BUFFER_POOL_CHANNELS    16    // Audio pool channels
 #endif
 
+#ifndef AUDIO_KEEP_SOURCE_DATA
+#define AUDIO_KEEP_SOURCE_DATA             1    // Keep a compact source copy of sounds, used to re-derive them on device sample rate changes
+#endif
+
+#ifndef MAX_AUDIO_BUFFER_HANDLES
+#define MAX_AUDIO_BUFFER_HANDLES        4096    // Max audio buffers addressable by handle (up to 65536)
+#endif
+#ifndef AUDIO_COMMAND_BUFFER_CAPACITY
+#define AUDIO_COMMAND_BUFFER_CAPACITY   1024    // Max commands queued between two RiqSubmitCommands() calls
+#endif
+
+#ifndef AUDIO_CALIBRATION_MAX_CLICKS
+#define AUDIO_CALIBRATION_MAX_CLICKS      32    // Max clicks in a latency calibration click train
+#endif
+#define AUDIO_CALIBRATION_CLICK_FRAMES    64    // Length of every calibration click (windowed noise burst)
+#define AUDIO_CALIBRATION_CLICK_LEVEL   0.5f    // Peak level of calibration clicks
+#ifndef AUDIO_CALIBRATION_MIN_CONFIDENCE
+#define AUDIO_CALIBRATION_MIN_CONFIDENCE 0.5f   // Min normalized correlation for a calibration to be trusted
+#endif
+
+#ifndef AUDIO_METER_MAX_CHANNELS
+#define AUDIO_METER_MAX_CHANNELS           8    // Max channels metered, extra channels are ignored
+#endif
+#ifndef AUDIO_METER_WINDOW_FRAMES
+#define AUDIO_METER_WINDOW_FRAMES       1024    // Frames covered by every meter snapshot
+#endif
+#ifndef AUDIO_SPECTRUM_SIZE
+#define AUDIO_SPECTRUM_SIZE             1024    // Spectrum FFT size, power of two (AUDIO_SPECTRUM_SIZE/2 bins)
+#endif
+#define AUDIO_SPECTRUM_RING_SIZE        (AUDIO_SPECTRUM_SIZE*4)   // Mix samples kept for the spectrum thread
+#ifndef AUDIO_SPECTRUM_INTERVAL_MS
+#define AUDIO_SPECTRUM_INTERVAL_MS        16    // Time between spectrum snapshots
+#endif
+
+#ifndef AUDIO_SILENCE_THRESHOLD_DB
+#define AUDIO_SILENCE_THRESHOLD_DB    -96.0f    // Level below which loaded sounds are considered silent (16bit LSB is ~-90dB)
+#endif
+#ifndef AUDIO_SILENCE_SKIP
+#define AUDIO_SILENCE_SKIP                 0    // Map silent spans of every sound (not only trimmed ones) so direct resamplers skip them
+#endif                                          // NOTE: Spans are below AUDIO_SILENCE_THRESHOLD_DB, not exact zeros, so skipping them is not bit-exact
+#ifndef AUDIO_SILENCE_MIN_SPAN_FRAMES
+#define AUDIO_SILENCE_MIN_SPAN_FRAMES   4096    // Min silent span length skipped by the mixer, shorter ones are mixed as usual
+#endif
+
+#ifndef SOUND_BANK_NAME_LENGTH
+#define SOUND_BANK_NAME_LENGTH            32    // Max sound name length in a sound bank, including null terminator
+#endif
+#define SOUND_BANK_VERSION                 1    // Sound bank file format version
+#define SOUND_BANK_DATA_ALIGNMENT         16    // Sound bank samples alignment in bytes
+
+#ifndef AUDIO_RESAMPLER_DEFAULT
+#define AUDIO_RESAMPLER_DEFAULT   AUDIO_RESAMPLER_CONVERTER  // Resampler used by new buffers, direct ones are opt-in (no anti-aliasing filter)
+#endif
+#ifndef AUDIO_RESAMPLER_MAX_CHANNELS
+#define AUDIO_RESAMPLER_MAX_CHANNELS       8    // Max channels handled by the direct resampler, others go through the data converter
+#endif
+
+#ifndef AUDIO_TEMPO_MIN
+#define AUDIO_TEMPO_MIN                 0.25f   // Min tempo (speed without pitch change)
+#endif
+#ifndef AUDIO_TEMPO_MAX
+#define AUDIO_TEMPO_MAX                 4.0f    // Max tempo (speed without pitch change)
+#endif
+
+#ifndef AUDIO_EFFECT_MAX_CHANNELS
+#define AUDIO_EFFECT_MAX_CHANNELS          8    // Max channels processed by built-in effects, extra channels are left dry
+#endif
+
+#ifndef AUDIO_UPMIX_CENTER_LEVEL
+#define AUDIO_UPMIX_CENTER_LEVEL        0.35f   // Center feed of mono/stereo sources on surround layouts: (L + R) * level
+#endif
+#ifndef AUDIO_UPMIX_SURROUND_LEVEL
+#define AUDIO_UPMIX_SURROUND_LEVEL      0.5f    // Surround feed: L and R * level on back speakers (5.1), split over side and back ones (7.1)
+#endif
+#ifndef AUDIO_UPMIX_LFE_LEVEL
+#define AUDIO_UPMIX_LFE_LEVEL           0.0f    // LFE feed: (L + R) * level, off by default as the mixer has no crossover
+#endif
+
+#ifndef WAVE_PEAKS_BASE_BIN_SHIFT
+#define WAVE_PEAKS_BASE_BIN_SHIFT          8    // Wave peaks level 0 bin size: 2^8 = 256 frames per bin
+#endif
+#ifndef WAVE_PEAKS_PARALLEL_MIN_BINS
+#define WAVE_PEAKS_PARALLEL_MIN_BINS    4096    // Minimum level 0 bins before peak generation is split across threads
+#endif
+
 // ================================================================================
 #pragma endregion
 // ================================================================================
@@ -32,6 +119,9 @@
 
 typedef void (*AudioCallback)(void* bufferdata, unsigned int frames);
 
+// Processes a block of interleaved float frames in place
+typedef void (*AudioProcessorCallback)(void* context, float* frames, unsigned int frameCount, unsigned int channels, unsigned int sampleRate);
+
 // Enums --------------------------------------------------------------------------
 
 typedef enum
@@ -49,8 +139,58 @@ typedef enum
 	AUDIO_BUFFER_USAGE_STREAM
 } AudioBufferUsage;
 
+typedef enum
+{
+	AUDIO_RESAMPLER_CONVERTER = 0,  // miniaudio data converter, supports any buffer
+	AUDIO_RESAMPLER_LINEAR,         // Direct linear interpolation, static buffers only
+	AUDIO_RESAMPLER_CUBIC           // Direct 4-point cubic interpolation, static buffers only
+} AudioResamplerQuality;
+
+typedef enum
+{
+	AUDIO_LAYOUT_DEFAULT = 0,       // Stereo
+	AUDIO_LAYOUT_MONO = 1,
+	AUDIO_LAYOUT_STEREO = 2,
+	AUDIO_LAYOUT_SURROUND_5_1 = 6,  // FL, FR, FC, LFE, BL, BR
+	AUDIO_LAYOUT_SURROUND_7_1 = 8   // FL, FR, FC, LFE, BL, BR, SL, SR
+} AudioChannelLayout;
+
+typedef enum
+{
+	AUDIO_COMMAND_PLAY = 0,
+	AUDIO_COMMAND_STOP,
+	AUDIO_COMMAND_PAUSE,
+	AUDIO_COMMAND_RESUME,
+	AUDIO_COMMAND_SET_VOLUME,
+	AUDIO_COMMAND_SET_PITCH,
+	AUDIO_COMMAND_SET_PAN,
+	AUDIO_COMMAND_SET_TEMPO,
+	AUDIO_COMMAND_SET_RESAMPLER
+} AudioCommandType;
+
+typedef enum
+{
+	AUDIO_EFFECT_EQ = 0,
+	AUDIO_EFFECT_LIMITER,
+	AUDIO_EFFECT_REVERB
+} AudioEffectType;
+
+typedef enum
+{
+	BIQUAD_LOWPASS = 0,
+	BIQUAD_HIGHPASS,
+	BIQUAD_BANDPASS,
+	BIQUAD_NOTCH,
+	BIQUAD_PEAK,
+	BIQUAD_LOWSHELF,
+	BIQUAD_HIGHSHELF
+} BiquadType;
+
 // Structs ------------------------------------------------------------------------
 
+// Built-in effect, opaque, plugs into processor chains
+typedef struct AudioEffect AudioEffect;
+
 typedef struct riqAudioProcessor
 {
 	AudioCallback process;          // Processor callback function
@@ -58,28 +198,101 @@ typedef struct riqAudioProcessor
 	riqAudioProcessor* prev;        // Previous audio processor on the list
 } riqAudioProcessor;
 
+// Processor chain entry
+typedef struct AudioProcessorEntry
+{
+	AudioProcessorCallback process; // Processor callback function
+	void* context;                  // User context passed to the callback
+} AudioProcessorEntry;
+
+// Silent span of a buffer data, in frames
+typedef struct SilenceSpan
+{
+	unsigned int start;             // First silent frame
+	unsigned int length;            // Number of silent frames
+} SilenceSpan;
+
+// Meter levels snapshot, published once every AUDIO_METER_WINDOW_FRAMES
+typedef struct AudioMeterLevels
+{
+	unsigned int sequence;          // Snapshot number, 0 if nothing was metered yet or it could not be read consistently
+	unsigned int channels;          // Number of metered channels
+	float peak[AUDIO_METER_MAX_CHANNELS];   // Peak absolute level in the window
+	float rms[AUDIO_METER_MAX_CHANNELS];    // Root mean square level in the window
+} AudioMeterLevels;
+
+// Level meter, accumulated by the audio thread and published as double buffered snapshots
+typedef struct AudioMeter
+{
+	std::atomic<unsigned int> sequence;     // Published snapshots count, latest one is snapshots[sequence & 1]
+	std::atomic<unsigned int> snapshots[2][sizeof(AudioMeterLevels)/sizeof(unsigned int)];   // Published AudioMeterLevels as words, read without locking
+	float peak[AUDIO_METER_MAX_CHANNELS];   // Current window peak, audio thread only
+	float sumSq[AUDIO_METER_MAX_CHANNELS];  // Current window sum of squares, audio thread only
+	unsigned int frameCount;                // Current window frames, audio thread only
+} AudioMeter;
+
+// Immutable processor chain, replaced as a whole on attach/detach so the audio thread never sees a partial chain
+typedef struct AudioProcessorChain
+{
+	unsigned int count;             // Number of processors
+	AudioProcessorEntry* entries;   // Processors, in processing order (same allocation as the chain)
+} AudioProcessorChain;
+
 struct riqAudioBuffer
 {
 	ma_data_converter converter;    // Audio data converter
 
 	AudioCallback callback;         // Audio buffer callback for buffer filling on audio threads
 	riqAudioProcessor* processor;   // Audio processor
+	std::atomic<AudioProcessorChain*> processorChain;   // Context aware processors chain, read by the audio thread
+	std::atomic<AudioMeter*> meter;                     // Level meter, NULL unless enabled
 
 	float volume;                   // Audio buffer volume
 	float pitch;                    // Audio buffer pitch
 	float pan;                      // Audio buffer pan (0.0f to 1.0f)
+	float tempo;                    // Audio buffer tempo, speed without pitch change (static buffers only)
+	struct TimeStretch* stretch;    // Time stretcher, allocated on first tempo change
 
-	bool playing;                   // Audio buffer state: AUDIO_PLAYING
-	bool paused;                    // Audio buffer state: AUDIO_PAUSED
+	std::atomic<bool> playing;      // Audio buffer state: AUDIO_PLAYING, readable from any thread
+	std::atomic<bool> paused;       // Audio buffer state: AUDIO_PAUSED, readable from any thread
 	bool looping;                   // Audio buffer looping, default to true for AudioStreams
 	int usage;                      // Audio buffer usage mode: STATIC or STREAM
 
+	int resampler;                  // Resampler quality: AudioResamplerQuality
+	unsigned int resamplePhase;     // Direct resampler fractional position, 32 bit fixed point
+
 	bool isSubBufferProcessed[2];   // SubBuffer processed (virtual double buffer)
 	unsigned int sizeInFrames;      // Total buffer size in frames
+	unsigned int sampleRate;        // Sample rate of data, input rate of the converter
 	unsigned int frameCursorPos;    // Frame cursor position
 	unsigned int framesProcessed;   // Total frames processed in this buffer (required for play timing)
 
 	unsigned char* data;            // Data buffer, on music stream keeps filling
+	bool sharedData;                // Data is a slice of a sound bank block, released with the bank
+	unsigned int handle;            // Compact handle used by the command buffer (0 if none)
+
+	struct
+	{
+		void* data;                 // Source data copy, data is re-derived from it when the device sample rate changes
+		ma_format format;           // Source data format
+		ma_uint32 channels;         // Source data channels
+		ma_uint32 sampleRate;       // Source data sample rate
+		ma_uint32 frameCount;       // Source data frame count
+		bool shared;                // Source data is a slice of a sound bank file, released with the bank
+	} source;
+
+	struct
+	{
+		SilenceSpan* spans;         // Run-length map of silent spans in data, skipped by the mixer
+		unsigned int spanCount;     // Number of silent spans
+		float threshold;            // Linear level spans were detected with, reused when data is re-derived
+		unsigned int leadFrames;    // Leading silence trimmed at load (at data sample rate)
+		unsigned int sourceLeadFrames;  // Leading silence trimmed at load (at source sample rate), leadFrames is rescaled from it
+		unsigned int delayFrames;   // Output frames left before data starts, trimmed silence played as a delay
+	} silence;
+
+	std::atomic<bool> unloading;    // Set on unload, the mixer unlinks the buffer on its next callback
+	riqAudioBuffer* nextUnloaded;   // Next buffer on the unload queue
 
 	riqAudioBuffer* next;           // Next audio buffer on the list
 	riqAudioBuffer* prev;           // Previous audio buffer on the list
@@ -97,6 +310,82 @@ typedef struct AudioStream
 
 typedef riqAudioBuffer AudioBuffer;
 
+// Audio device init options, zero values let the backend decide
+typedef struct AudioDeviceOptions
+{
+	unsigned int sampleRate;        // Requested sample rate, 0 for the device native rate
+	unsigned int periodSizeInFrames;// Requested period size in frames, 0 for the backend default
+	unsigned int periods;           // Requested number of periods, 0 for the backend default
+	int lowLatency;                 // Use the low latency performance profile (0 or 1)
+	int backend;                    // Preferred backend (ma_backend value), -1 for default priority order
+	int layout;                     // Output channel layout (AudioChannelLayout)
+} AudioDeviceOptions;
+
+// Audio device values negotiated with the backend
+typedef struct AudioDeviceInfo
+{
+	unsigned int sampleRate;        // Device sample rate used for mixing
+	unsigned int channels;          // Device output channels
+	unsigned int periodSizeInFrames;// Backend period size in frames (at internalSampleRate)
+	unsigned int periods;           // Backend number of periods
+	unsigned int internalSampleRate;// Backend native sample rate
+	unsigned int latencyFrames;     // Estimated output latency in frames (at sampleRate)
+	float latencyMs;                // Estimated output latency in milliseconds
+	int backend;                    // Backend in use (ma_backend value)
+} AudioDeviceInfo;
+
+// Mixing callback statistics, since init or the last reset
+typedef struct AudioMixerStats
+{
+	unsigned long long callbackCount;   // Mixing callbacks
+	unsigned long long framesMixed;     // Frames mixed
+	unsigned int buffersMixed;          // Buffers playing in the last callback
+	unsigned int maxBuffersMixed;       // Most buffers playing in a single callback
+	unsigned int overruns;              // Callbacks that took longer than the audio they produced
+	float lastCallbackMs;               // Last callback time, lock wait included
+	float averageCallbackMs;            // Average callback time
+	float worstCallbackMs;              // Worst callback time
+	float worstLoad;                    // Worst callback time over the duration of its frames, 1.0 is realtime
+} AudioMixerStats;
+
+// Latency calibration options
+typedef struct AudioCalibrationOptions
+{
+	int clickCount;                 // Number of clicks emitted (up to AUDIO_CALIBRATION_MAX_CLICKS)
+	unsigned int clickIntervalMs;   // Average time between clicks, clicks are spaced unevenly around it
+	unsigned int maxLatencyMs;      // Longest round trip searched for
+	unsigned int syntheticLoopbackFrames;   // If > 0, the output delayed by this many frames is added to the captured signal
+} AudioCalibrationOptions;
+
+// Latency calibration result, frames are at the device sample rate
+typedef struct AudioLatencyCalibration
+{
+	int success;                    // Click train found in the captured signal (0 or 1)
+	unsigned int sampleRate;        // Device sample rate during calibration
+	unsigned int roundTripFrames;   // Measured time from emitting a click to capturing it
+	unsigned int inputLatencyFrames;// Estimated capture side latency (one capture period)
+	unsigned int outputLatencyFrames;// Round trip minus input latency
+	float roundTripMs;              // Round trip in milliseconds
+	float outputLatencyMs;          // Output latency in milliseconds
+	float confidence;               // Normalized correlation of the match (0.0f to 1.0f)
+} AudioLatencyCalibration;
+
+// Audio command, queued by the game and applied on RiqSubmitCommands()
+typedef struct AudioCommand
+{
+	unsigned int type;              // Command type: AudioCommandType
+	unsigned int handle;            // Target audio buffer handle
+	float value;                    // Command parameter (volume, pitch, pan, tempo), unused by state commands
+} AudioCommand;
+
+// Audio command buffer, allocated natively and written directly by the game
+typedef struct AudioCommandBuffer
+{
+	AudioCommand* commands;         // Commands array
+	unsigned int capacity;          // Max number of commands
+	unsigned int count;             // Number of queued commands
+} AudioCommandBuffer;
+
 typedef struct AudioData
 {
 	struct 
@@ -104,7 +393,12 @@ typedef struct AudioData
 		ma_context context;         // miniaudio context data
 		ma_device device;           // miniaudio device
 		ma_mutex lock;              // miniaudio mutex lock
+		ma_mutex rebakeLock;        // Held while a buffer data is re-derived on a sample rate change, unload waits on it
+		ma_spinlock gameLock;       // Serializes processor chain writers and sound meter users across game threads, never taken by the audio thread
+		std::atomic<unsigned int> callbackEpoch;    // Incremented on audio callback entry and exit, odd while mixing
 		bool isReady;               // Check if audio device is ready
+		bool offline;               // Device is not started, mix is pulled by RiqRenderAudio()
+		AudioDeviceOptions options; // Options the device was initialized with, reused when it restarts
 		size_t pcmBufferSize;       // Preallocated buffer size
 		void* pcmBuffer;            // Preallocated buffer to read audio data from file/memory
 	} System;
@@ -114,7 +408,59 @@ typedef struct AudioData
 		AudioBuffer* last;          // Pointer to last AudioBuffer in the list
 		int defaultSize = 0;        // Default audio buffer size for audio streams
 	} Buffer;
+	struct
+	{
+		AudioBuffer* slots[MAX_AUDIO_BUFFER_HANDLES];                   // Audio buffers by handle index
+		unsigned short generations[MAX_AUDIO_BUFFER_HANDLES];           // Handle generation, invalidates stale handles
+		unsigned short freeIndices[MAX_AUDIO_BUFFER_HANDLES];           // Stack of released handle indices
+		int freeCount;                                                  // Number of released handle indices
+		int nextIndex;                                                  // First never used handle index
+	} Handle;
+	struct
+	{
+		std::atomic<AudioBuffer*> pending;  // Unloaded buffers waiting for the mixer to unlink them
+		std::atomic<AudioBuffer*> unlinked; // Buffers unlinked by the mixer, retired by the next reclaim
+	} Unload;
+	struct
+	{
+		ma_spinlock lock;                   // Retired list lock, never taken by the audio thread
+		struct RetiredMemory* first;        // Memory waiting for the audio thread to move past its epoch
+	} Retire;
+	struct
+	{
+		std::atomic<bool> active;   // Click train playing and loopback being recorded, cleared by the audio thread when done
+		float* reference;           // Click train, mono
+		float* recording;           // Captured loopback signal, mono
+		unsigned int emitFrames;    // Frames of click train
+		unsigned int frameCount;    // Frames to record (click train plus longest latency searched for)
+		unsigned int position;      // Frames played and recorded so far
+		unsigned int syntheticDelay;// Synthetic loopback delay in frames, 0 to record the capture device alone
+	} Calibration;
+	struct
+	{
+		ma_uint64 callbackCount;    // Mixing callbacks since the last reset
+		ma_uint64 framesMixed;      // Frames mixed since the last reset
+		ma_uint64 totalNs;          // Summed callback time
+		ma_uint64 lastNs;           // Last callback time
+		ma_uint64 worstNs;          // Worst callback time
+		unsigned int buffersMixed;  // Buffers playing in the last callback
+		unsigned int maxBuffersMixed;
+		unsigned int overruns;      // Callbacks slower than realtime
+		float worstLoad;            // Worst callback time over its frames duration
+	} Stats;                            // Mixer statistics, written by the audio thread under the mixing lock
+	AudioMeter Meter;                   // Master level meter
+	struct
+	{
+		std::atomic<bool> enabled;                  // Spectrum thread running, mix is fed to the ring
+		std::atomic<float> ring[AUDIO_SPECTRUM_RING_SIZE];  // Latest mix samples, mono
+		std::atomic<unsigned int> writePos;         // Total samples written to the ring
+		std::atomic<unsigned int> writeEnd;         // Total samples once the batch being written is done, moved before its stores
+		std::atomic<unsigned int> sequence;         // Published snapshots count, latest one is snapshots[sequence & 1]
+		std::atomic<unsigned int> snapshots[2][AUDIO_SPECTRUM_SIZE/2];  // Published magnitudes as float words, read without locking
+	} Spectrum;
+	AudioCommandBuffer commandBuffer;   // Commands queued by the game
 	riqAudioProcessor* mixedProcessor = NULL;
+	std::atomic<AudioProcessorChain*> mixedProcessorChain;  // Context aware processors chain applied to the final mix
 
 } AudioData;
 
@@ -135,6 +481,59 @@ typedef struct Sound
 	unsigned int frameCount;
 } Sound;
 
+// Sound bank file header, followed by the entries index and the samples data block
+// NOTE: Values are stored in the byte order of the exporting platform, a bank from the other byte order fails the version check
+typedef struct SoundBankHeader
+{
+	char magic[4];                  // File identifier: "RIQB"
+	unsigned int version;           // File format version: SOUND_BANK_VERSION
+	unsigned int soundCount;        // Number of entries in the index
+	unsigned int dataOffset;        // Samples data block offset in the file
+	unsigned int dataSize;          // Samples data block size in bytes
+} SoundBankHeader;
+
+// Sound bank index entry
+typedef struct SoundBankEntry
+{
+	char name[SOUND_BANK_NAME_LENGTH];  // Sound name, used for lookup
+	unsigned int offset;            // Samples offset in the data block
+	unsigned int frameCount;        // Total number of frames
+	unsigned int sampleRate;        // Frequency (samples per second)
+	unsigned short channels;        // Number of channels
+	unsigned short sampleSize;      // Bit depth (bits per sample): 8, 16, 32
+} SoundBankEntry;
+
+// Sound bank, many sounds sharing one contiguous samples block
+typedef struct SoundBank
+{
+	unsigned int soundCount;        // Number of sounds
+	SoundBankEntry* entries;        // Sounds index
+	Sound* sounds;                  // Sounds, data are slices of sampleData or fileData
+	void* sampleData;               // Samples converted to device format, all sounds in one block
+	void* fileData;                 // Bank file data, kept when sounds play from it or as source data
+} SoundBank;
+
+// Wave peak bin, one per channel
+typedef struct WavePeak
+{
+	float min;                  // Lowest sample value in the bin
+	float max;                  // Highest sample value in the bin
+	float rms;                  // Root mean square of the bin
+} WavePeak;
+
+// Wave peaks pyramid, used for waveform visualization
+// NOTE: Level N bins cover 2^(baseBinShift + N) frames, all levels are packed in data (level 0 first),
+// every bin holds one WavePeak per channel, interleaved like audio frames
+typedef struct WavePeaks
+{
+	unsigned int frameCount;    // Total number of frames covered by the pyramid
+	unsigned int sampleRate;    // Frequency of the source data (samples per second)
+	unsigned int channels;      // Number of channels of the source data
+	unsigned int baseBinShift;  // Level 0 bin size in frames, as a power of two
+	unsigned int levelCount;    // Number of levels in the pyramid
+	void* data;                 // WavePeak data pointer
+} WavePeaks;
+
 // Music, audio stream, anything longer than ~10 seconds should be streamed
 typedef struct Music
 {
@@ -158,28 +557,90 @@ void PlayAudioBuffer(AudioBuffer* buffer);
 void StopAudioBuffer(AudioBuffer* buffer);
 void PauseAudioBuffer(AudioBuffer* buffer);
 void ResumeAudioBuffer(AudioBuffer* buffer);
-// void SetAudioBufferVolume(AudioBuffer* buffer, float volume);
-// void SetAudioBufferPitch(AudioBuffer* buffer, float pitch);
-// void SetAudioBufferPan(AudioBuffer* buffer, float pan);
+void SetAudioBufferVolume(AudioBuffer* buffer, float volume);
+void SetAudioBufferPitch(AudioBuffer* buffer, float pitch);
+void SetAudioBufferPan(AudioBuffer* buffer, float pan);
+void SetAudioBufferTempo(AudioBuffer* buffer, float tempo);
+void SetAudioBufferResampler(AudioBuffer* buffer, int resampler);
 void TrackAudioBuffer(AudioBuffer* buffer);
 void UntrackAudioBuffer(AudioBuffer* buffer);
+AudioBuffer* GetAudioBufferFromHandle(unsigned int handle);
 
 extern "C"
 {
 DllExport void RiqInitAudioDevice(void);
+DllExport void RiqInitAudioDeviceEx(AudioDeviceOptions options);
+DllExport AudioDeviceOptions RiqGetDefaultAudioDeviceOptions(void);
+DllExport AudioDeviceInfo RiqGetAudioDeviceInfo(void);
+DllExport AudioMixerStats RiqGetMixerStats(void);
+DllExport void RiqResetMixerStats(void);
+DllExport void RiqInitAudioOffline(unsigned int sampleRate);
+DllExport void RiqInitAudioOfflineEx(AudioDeviceOptions options);
+// NOTE: RiqRenderAudio() stands for the audio thread, it must never be called from two threads
+DllExport unsigned int RiqRenderAudio(float* framesOut, unsigned int frameCount);
+DllExport AudioCalibrationOptions RiqGetDefaultAudioCalibrationOptions(void);
+DllExport AudioLatencyCalibration RiqCalibrateAudioLatency(AudioCalibrationOptions options);
 DllExport void RiqCloseAudioDevice(void);
 DllExport bool IsRiqReady();
 
 DllExport Sound RiqLoadSound(const char* filePath);
 DllExport Sound RiqLoadSoundFromWave(Wave wave);
+// NOTE: Trimmed sounds at the device sample rate play sample for sample like untrimmed ones, except the converter
+// low-pass filter ringing past the trimmed tail (below the threshold)
+DllExport Sound RiqLoadSoundTrimmed(const char* filePath, float thresholdDb);
+DllExport Sound RiqLoadSoundFromWaveTrimmed(Wave wave, float thresholdDb);
+DllExport unsigned int RiqGetSoundTrimOffset(Sound sound);
 DllExport void RiqUnloadSound(Sound sound);
 DllExport void RiqPlaySound(Sound sound);
+DllExport unsigned int RiqGetSoundHandle(Sound sound);
+DllExport void RiqSetSoundTempo(Sound sound, float tempo);
+DllExport double RiqGetSoundSourcePosition(Sound sound);
+DllExport void RiqSetSoundResampler(Sound sound, int resampler);
+
+DllExport SoundBank RiqLoadSoundBank(const char* filePath);
+DllExport void RiqUnloadSoundBank(SoundBank bank);
+DllExport int RiqGetSoundBankIndex(SoundBank bank, const char* name);
+DllExport Sound RiqGetSoundBankSound(SoundBank bank, const char* name);
+DllExport bool RiqExportSoundBank(const Wave* waves, const char** names, int count, const char* fileName);
+
+DllExport bool RiqAttachSoundProcessor(Sound sound, AudioProcessorCallback process, void* context);
+// NOTE: Detach returns once the audio thread is done with the processor, context can be released right after
+DllExport void RiqDetachSoundProcessor(Sound sound, AudioProcessorCallback process, void* context);
+DllExport bool RiqAttachMixedProcessor(AudioProcessorCallback process, void* context);
+DllExport void RiqDetachMixedProcessor(AudioProcessorCallback process, void* context);
+
+DllExport AudioEffect* RiqLoadEffectEQ(int stageCount);
+DllExport AudioEffect* RiqLoadEffectLowPass(float cutoff);
+DllExport AudioEffect* RiqLoadEffectLimiter(float thresholdDb, float lookaheadMs, float releaseMs);
+DllExport AudioEffect* RiqLoadEffectReverb(float roomSize, float damping, float wet);
+DllExport void RiqSetEffectEQStage(AudioEffect* effect, int stage, int type, float frequency, float q, float gainDb);
+DllExport void RiqSetEffectLimiter(AudioEffect* effect, float thresholdDb, float releaseMs);
+DllExport void RiqSetEffectReverb(AudioEffect* effect, float roomSize, float damping, float wet);
+DllExport void RiqUnloadEffect(AudioEffect* effect);
+// NOTE: An effect runs on one chain (a sound or the final mix) at a time, attaching an attached effect fails
+DllExport bool RiqAttachSoundEffect(Sound sound, AudioEffect* effect);
+DllExport void RiqDetachSoundEffect(Sound sound, AudioEffect* effect);
+DllExport bool RiqAttachMixedEffect(AudioEffect* effect);
+DllExport void RiqDetachMixedEffect(AudioEffect* effect);
+
+DllExport AudioMeterLevels RiqGetMasterMeter(void);
+DllExport bool RiqEnableSoundMeter(Sound sound);
+DllExport void RiqDisableSoundMeter(Sound sound);
+DllExport AudioMeterLevels RiqGetSoundMeter(Sound sound);
+DllExport void RiqEnableSpectrum(bool enable);
+DllExport int RiqGetSpectrum(float* magnitudesOut, int binCount);
+
+DllExport AudioCommandBuffer* RiqGetCommandBuffer(void);
+DllExport void RiqSubmitCommands(void);
 
 
 DllExport Wave RiqLoadWave(const char* filePath);
 DllExport Wave RiqLoadWaveFromMemory(const char* fileType, const unsigned char* fileData, int dataSize);
 DllExport void RiqUnloadWave(Wave wave);
-}
 
-static const char* GetFileExtension(const char* fileName);
-unsigned char* LoadFileData(const char* fileName, unsigned int* bytesRead);
\ No newline at end of file
+DllExport WavePeaks RiqLoadWavePeaks(Wave wave);
+DllExport WavePeaks RiqLoadWavePeaksFromSound(Sound sound);
+DllExport void RiqUnloadWavePeaks(WavePeaks peaks);
+// NOTE: binsOut must hold binCount*peaks.channels WavePeak entries, one per channel for every bin
+DllExport int RiqGetWavePeaks(WavePeaks peaks, unsigned int startFrame, unsigned int frameCount, WavePeak* binsOut, int binCount);
+}
\ No newline at end of file
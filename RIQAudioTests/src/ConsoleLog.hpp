@@ -0,0 +1,36 @@
+#pragma once
+
+#include "IUnityInterface.h"
+#include "IUnityLog.h"
+
+#include <stdio.h>
+
+// Library logs through the Unity interface, console tools hand it this one before using the library:
+// warnings and errors are printed, regular logs are dropped
+
+static void UNITY_INTERFACE_API LogToConsole(UnityLogType type, const char* message, const char* fileName, const int fileLine)
+{
+	(void)fileName;
+	(void)fileLine;
+
+	if (type != kUnityLogTypeLog) fprintf(stderr, "    [%s] %s\n", (type == kUnityLogTypeWarning) ? "warning" : "error", message);
+}
+
+static IUnityLog consoleLog = { {}, LogToConsole };
+
+static IUnityInterface* UNITY_INTERFACE_API GetConsoleInterface(UnityInterfaceGUID guid)
+{
+	return (guid == GetUnityInterfaceGUID<IUnityLog>()) ? (IUnityInterface*)&consoleLog : NULL;
+}
+
+static IUnityInterfaces consoleInterfaces = { GetConsoleInterface, NULL, NULL, NULL };
+
+static inline void LoadConsoleLog(void)
+{
+	UnityPluginLoad(&consoleInterfaces);
+}
+
+static inline void UnloadConsoleLog(void)
+{
+	UnityPluginUnload();
+}
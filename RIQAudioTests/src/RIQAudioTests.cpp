@@ -0,0 +1,865 @@
+// Golden render tests, every scenario is scripted against the offline mixer and compared with a checked in render
+//
+// Usage: RIQAudioTests [--update] [goldenDir]
+//
+// Checks run after the scenarios, they compare two renders or read values back instead of using a golden
+// (sound bank round trip, trimmed against untrimmed sounds, meter and spectrum levels, ...). Warnings printed while a check feeds corrupted data are expected.
+// The latency calibration check runs a real time device on the null backend.
+//
+// Golden files are raw interleaved float-32 renders (little endian, device channels), one per scenario.
+// The scalar build (RIQ_NO_SIMD, ReleaseNoSIMD configuration) must match them bit for bit, SIMD builds
+// sum and round in a different order and are allowed GOLDEN_SIMD_TOLERANCE of absolute error per sample.
+// NOTE: Goldens are rendered by the scalar build. Effects and resamplers go through the C math library,
+// a toolchain whose libm rounds differently needs its goldens regenerated with --update (and reviewed)
+
+#include "RIQAudio.hpp"
+#include "ConsoleLog.hpp"
+
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Max absolute error per sample allowed for SIMD builds, 16bit LSB is ~3e-5
+#define GOLDEN_SIMD_TOLERANCE       1e-5f
+
+#define GOLDEN_SAMPLE_RATE          48000
+#define GOLDEN_BLOCK_FRAMES         480     // Frames rendered per mixing callback, a 10ms device period
+
+// ================================================================================
+#pragma region Scenario Helpers
+// ================================================================================
+
+// Seeded source sounds, generated without the math library so they are the same on every toolchain
+typedef enum
+{
+	SOURCE_NOISE_BURST = 0,         // Noise with a linear decay
+	SOURCE_SQUARE,                  // Square wave, band unlimited on purpose
+	SOURCE_TRIANGLE                 // Triangle wave
+} SourceShape;
+
+typedef struct Render
+{
+	std::vector<float> frames;      // Rendered frames, interleaved
+	unsigned int channels;          // Device channels
+} Render;
+
+static unsigned int randomSeed = 0;
+
+static float GetRandomSample(void)
+{
+	randomSeed = randomSeed * 1664525u + 1013904223u;
+
+	return ((float)(randomSeed >> 8) / 8388608.0f) - 1.0f;
+}
+
+// Builds a 16bit stereo wave into samples, left and right are slightly different so panning and layouts show up
+static Wave GenerateSourceWave(SourceShape shape, unsigned int sampleRate, unsigned int frameCount, unsigned int period, float level, std::vector<short>* samples)
+{
+	samples->resize((size_t)frameCount * 2);
+
+	for (unsigned int i = 0; i < frameCount; i++)
+	{
+		float value = 0.0f;
+		unsigned int phase = i % period;
+
+		switch (shape)
+		{
+			case SOURCE_NOISE_BURST: value = GetRandomSample() * (1.0f - (float)i / (float)frameCount); break;
+			case SOURCE_SQUARE: value = (phase < period / 2) ? 1.0f : -1.0f; break;
+			case SOURCE_TRIANGLE: value = (phase < period / 2) ? (4.0f * phase / period - 1.0f) : (3.0f - 4.0f * phase / period); break;
+			default: break;
+		}
+
+		(*samples)[i * 2] = (short)(value * level * 32767.0f);
+		(*samples)[i * 2 + 1] = (short)(value * level * 0.8f * 32767.0f);
+	}
+
+	Wave wave = { 0 };
+	wave.frameCount = frameCount;
+	wave.sampleRate = sampleRate;
+	wave.sampleSize = 16;
+	wave.channels = 2;
+	wave.data = samples->data();
+
+	return wave;
+}
+
+static Sound LoadSourceSound(SourceShape shape, unsigned int sampleRate, unsigned int frameCount, unsigned int period, float level)
+{
+	std::vector<short> samples;
+
+	return RiqLoadSoundFromWave(GenerateSourceWave(shape, sampleRate, frameCount, period, level, &samples));
+}
+
+static void QueueSoundCommand(AudioCommandType type, Sound sound, float value)
+{
+	AudioCommandBuffer* commandBuffer = RiqGetCommandBuffer();
+	if (commandBuffer->count >= commandBuffer->capacity) return;
+
+	AudioCommand* command = &commandBuffer->commands[commandBuffer->count++];
+	command->type = (unsigned int)type;
+	command->handle = RiqGetSoundHandle(sound);
+	command->value = value;
+}
+
+// Renders frameCount frames in device period sized blocks, appended to the render
+static void RenderFrames(Render* render, unsigned int frameCount)
+{
+	std::vector<float> block((size_t)GOLDEN_BLOCK_FRAMES * render->channels);
+
+	while (frameCount > 0)
+	{
+		unsigned int framesNow = (frameCount < GOLDEN_BLOCK_FRAMES) ? frameCount : GOLDEN_BLOCK_FRAMES;
+
+		RiqRenderAudio(block.data(), framesNow);
+		render->frames.insert(render->frames.end(), block.begin(), block.begin() + (size_t)framesNow * render->channels);
+
+		frameCount -= framesNow;
+	}
+}
+
+// ================================================================================
+#pragma endregion
+// ================================================================================
+
+// ================================================================================
+#pragma region Scenarios
+// ================================================================================
+
+// Overlapping one-shots at different rates, volumes and pans, one retriggered while playing
+static void RunOneShots(Render* render)
+{
+	Sound burst = LoadSourceSound(SOURCE_NOISE_BURST, 44100, 6000, 1, 0.6f);
+	Sound square = LoadSourceSound(SOURCE_SQUARE, 48000, 4000, 96, 0.25f);
+	Sound triangle = LoadSourceSound(SOURCE_TRIANGLE, 22050, 3000, 50, 0.5f);
+
+	RiqPlaySound(burst);
+	RenderFrames(render, 1200);
+
+	QueueSoundCommand(AUDIO_COMMAND_SET_PAN, square, 0.2f);
+	QueueSoundCommand(AUDIO_COMMAND_SET_VOLUME, square, 0.7f);
+	QueueSoundCommand(AUDIO_COMMAND_PLAY, square, 0.0f);
+	RiqSubmitCommands();
+	RenderFrames(render, 2400);
+
+	QueueSoundCommand(AUDIO_COMMAND_SET_PAN, triangle, 0.9f);
+	QueueSoundCommand(AUDIO_COMMAND_PLAY, triangle, 0.0f);
+	QueueSoundCommand(AUDIO_COMMAND_PLAY, burst, 0.0f);
+	RiqSubmitCommands();
+	RenderFrames(render, 6000);
+
+	RiqUnloadSound(burst);
+	RiqUnloadSound(square);
+	RiqUnloadSound(triangle);
+}
+
+// Short resampled loop wrapping many times, paused, resumed and stopped
+static void RunLooping(Render* render)
+{
+	Sound loop = LoadSourceSound(SOURCE_TRIANGLE, 44100, 1003, 59, 0.5f);
+	loop.stream.buffer->looping = true;
+
+	RiqPlaySound(loop);
+	RenderFrames(render, 4000);
+
+	QueueSoundCommand(AUDIO_COMMAND_PAUSE, loop, 0.0f);
+	RiqSubmitCommands();
+	RenderFrames(render, 960);
+
+	QueueSoundCommand(AUDIO_COMMAND_RESUME, loop, 0.0f);
+	RiqSubmitCommands();
+	RenderFrames(render, 3000);
+
+	QueueSoundCommand(AUDIO_COMMAND_STOP, loop, 0.0f);
+	RiqSubmitCommands();
+	RenderFrames(render, 1040);
+
+	RiqUnloadSound(loop);
+}
+
+// Pitch changes while playing, on both resamplers, and a time stretched sound
+static void RunPitchTempo(Render* render)
+{
+	Sound pitched = LoadSourceSound(SOURCE_SQUARE, 48000, 9000, 120, 0.3f);
+	Sound direct = LoadSourceSound(SOURCE_TRIANGLE, 32000, 9000, 80, 0.3f);
+	Sound stretched = LoadSourceSound(SOURCE_NOISE_BURST, 48000, 9000, 1, 0.4f);
+
+	QueueSoundCommand(AUDIO_COMMAND_SET_PITCH, pitched, 1.5f);
+	QueueSoundCommand(AUDIO_COMMAND_SET_RESAMPLER, direct, (float)AUDIO_RESAMPLER_CUBIC);
+	QueueSoundCommand(AUDIO_COMMAND_SET_PITCH, direct, 0.75f);
+	QueueSoundCommand(AUDIO_COMMAND_SET_TEMPO, stretched, 0.8f);
+	QueueSoundCommand(AUDIO_COMMAND_PLAY, pitched, 0.0f);
+	QueueSoundCommand(AUDIO_COMMAND_PLAY, direct, 0.0f);
+	QueueSoundCommand(AUDIO_COMMAND_PLAY, stretched, 0.0f);
+	RiqSubmitCommands();
+	RenderFrames(render, 4800);
+
+	QueueSoundCommand(AUDIO_COMMAND_SET_PITCH, pitched, 0.9f);
+	QueueSoundCommand(AUDIO_COMMAND_SET_PITCH, direct, 1.25f);
+	RiqSubmitCommands();
+	RenderFrames(render, 4800);
+
+	RiqUnloadSound(pitched);
+	RiqUnloadSound(direct);
+	RiqUnloadSound(stretched);
+}
+
+// Per sound EQ and reverb, limiter on the mix driven into reduction
+static void RunEffects(Render* render)
+{
+	Sound square = LoadSourceSound(SOURCE_SQUARE, 48000, 8000, 64, 0.9f);
+	Sound burst = LoadSourceSound(SOURCE_NOISE_BURST, 48000, 4000, 1, 0.9f);
+
+	AudioEffect* eq = RiqLoadEffectEQ(2);
+	RiqSetEffectEQStage(eq, 0, BIQUAD_LOWPASS, 2000.0f, 0.707f, 0.0f);
+	RiqSetEffectEQStage(eq, 1, BIQUAD_PEAK, 750.0f, 2.0f, 6.0f);
+
+	AudioEffect* reverb = RiqLoadEffectReverb(0.7f, 0.4f, 0.35f);
+	AudioEffect* limiter = RiqLoadEffectLimiter(-6.0f, 2.0f, 50.0f);
+
+	RiqAttachSoundEffect(square, eq);
+	RiqAttachSoundEffect(burst, reverb);
+	RiqAttachMixedEffect(limiter);
+
+	RiqPlaySound(square);
+	RiqPlaySound(burst);
+	RenderFrames(render, 9600);
+
+	RiqDetachMixedEffect(limiter);
+	RiqUnloadSound(square);
+	RiqUnloadSound(burst);
+
+	RiqUnloadEffect(eq);
+	RiqUnloadEffect(reverb);
+	RiqUnloadEffect(limiter);
+}
+
+// Panned one-shots, rendered once per output layout
+static void RunLayout(Render* render)
+{
+	Sound left = LoadSourceSound(SOURCE_TRIANGLE, 48000, 3000, 48, 0.5f);
+	Sound right = LoadSourceSound(SOURCE_SQUARE, 44100, 3000, 70, 0.3f);
+
+	// Sound chains stay stereo on every layout, the limiter has to follow them
+	AudioEffect* limiter = RiqLoadEffectLimiter(-18.0f, 1.0f, 20.0f);
+	RiqAttachSoundEffect(right, limiter);
+
+	QueueSoundCommand(AUDIO_COMMAND_SET_PAN, left, 0.0f);
+	QueueSoundCommand(AUDIO_COMMAND_SET_PAN, right, 0.85f);
+	QueueSoundCommand(AUDIO_COMMAND_PLAY, left, 0.0f);
+	QueueSoundCommand(AUDIO_COMMAND_PLAY, right, 0.0f);
+	RiqSubmitCommands();
+	RenderFrames(render, 4000);
+
+	RiqUnloadSound(left);
+	RiqUnloadSound(right);
+	RiqUnloadEffect(limiter);
+}
+
+typedef struct Scenario
+{
+	const char* name;               // Golden file name, without extension
+	int layout;                     // Output layout (AudioChannelLayout)
+	void (*run)(Render* render);    // Scenario script
+} Scenario;
+
+static const Scenario scenarios[] = {
+	{ "oneshots", AUDIO_LAYOUT_STEREO, RunOneShots },
+	{ "looping", AUDIO_LAYOUT_STEREO, RunLooping },
+	{ "pitch_tempo", AUDIO_LAYOUT_STEREO, RunPitchTempo },
+	{ "effects", AUDIO_LAYOUT_STEREO, RunEffects },
+	{ "layout_mono", AUDIO_LAYOUT_MONO, RunLayout },
+	{ "layout_stereo", AUDIO_LAYOUT_STEREO, RunLayout },
+	{ "layout_5_1", AUDIO_LAYOUT_SURROUND_5_1, RunLayout },
+	{ "layout_7_1", AUDIO_LAYOUT_SURROUND_7_1, RunLayout },
+};
+
+// ================================================================================
+#pragma endregion
+// ================================================================================
+
+// ================================================================================
+#pragma region Checks
+// ================================================================================
+
+typedef struct Check
+{
+	const char* name;               // Check name
+	bool (*run)(std::string* failure);  // Check script, failure describes what went wrong
+} Check;
+
+static std::string FormatFailure(const char* format, ...)
+{
+	char message[256];
+
+	va_list args;
+	va_start(args, format);
+	vsnprintf(message, sizeof(message), format, args);
+	va_end(args);
+
+	return message;
+}
+
+// Starts an offline stereo mixer at the golden sample rate, checks script their own sessions
+static bool InitCheckMixer(std::string* failure)
+{
+	AudioDeviceOptions options = RiqGetDefaultAudioDeviceOptions();
+	options.sampleRate = GOLDEN_SAMPLE_RATE;
+	options.layout = AUDIO_LAYOUT_STEREO;
+
+	RiqInitAudioOfflineEx(options);
+	if (!IsRiqReady()) *failure = "offline mixer did not start";
+
+	return IsRiqReady();
+}
+
+// Compares two renders of the same script sample for sample
+static bool CompareRenders(const Render& expected, const Render& actual, float tolerance, const char* what, std::string* failure)
+{
+	if (expected.frames.size() != actual.frames.size())
+	{
+		*failure = FormatFailure("%s: %i samples rendered, expected %i", what, (int)actual.frames.size(), (int)expected.frames.size());
+		return false;
+	}
+
+	for (size_t i = 0; i < expected.frames.size(); i++)
+	{
+		float error = fabsf(actual.frames[i] - expected.frames[i]);
+		if (!(error <= tolerance))
+		{
+			*failure = FormatFailure("%s: frame %i channel %i differs by %g", what, (int)(i / expected.channels), (int)(i % expected.channels), error);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool LoadFileBytes(const char* fileName, std::vector<unsigned char>* bytes)
+{
+	FILE* file = fopen(fileName, "rb");
+	if (file == NULL) return false;
+
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	bytes->resize((size > 0) ? (size_t)size : 0);
+	size_t count = fread(bytes->data(), 1, bytes->size(), file);
+	fclose(file);
+
+	return (count == bytes->size());
+}
+
+static bool SaveFileBytes(const char* fileName, const std::vector<unsigned char>& bytes)
+{
+	FILE* file = fopen(fileName, "wb");
+	if (file == NULL) return false;
+
+	size_t count = fwrite(bytes.data(), 1, bytes.size(), file);
+	fclose(file);
+
+	return (count == bytes.size());
+}
+
+#define CHECK_BANK_FILE             "RIQAudioTests.riqb"    // Scratch bank, removed once the check is done
+#define CHECK_BANK_SOUNDS           3
+
+// Plays every bank sound at once, the same script renders plain loads and bank sounds
+static void RenderBankSounds(Render* render, const Sound* sounds)
+{
+	QueueSoundCommand(AUDIO_COMMAND_SET_PAN, sounds[0], 0.3f);
+	for (int i = 0; i < CHECK_BANK_SOUNDS; i++) QueueSoundCommand(AUDIO_COMMAND_PLAY, sounds[i], 0.0f);
+	RiqSubmitCommands();
+
+	RenderFrames(render, 6000);
+}
+
+// Exported bank loads back and renders exactly like the plain loads, a corrupted index is rejected
+static bool CheckSoundBank(std::string* failure)
+{
+	if (!InitCheckMixer(failure)) return false;
+
+	// Resampled 16bit sounds plus a device format one, played in place from the file data
+	std::vector<short> samples[CHECK_BANK_SOUNDS];
+	Wave waves[CHECK_BANK_SOUNDS] = {
+		GenerateSourceWave(SOURCE_NOISE_BURST, 44100, 3001, 1, 0.5f, &samples[0]),
+		GenerateSourceWave(SOURCE_TRIANGLE, 22050, 2000, 50, 0.4f, &samples[1]),
+		GenerateSourceWave(SOURCE_SQUARE, GOLDEN_SAMPLE_RATE, 4000, 96, 0.3f, &samples[2]),
+	};
+
+	std::vector<float> deviceSamples((size_t)waves[2].frameCount * 2);
+	for (size_t i = 0; i < deviceSamples.size(); i++) deviceSamples[i] = (float)samples[2][i] / 32768.0f;
+	waves[2].sampleSize = 32;
+	waves[2].data = deviceSamples.data();
+
+	const char* names[CHECK_BANK_SOUNDS] = { "burst", "triangle", "square" };
+
+	Sound plain[CHECK_BANK_SOUNDS];
+	for (int i = 0; i < CHECK_BANK_SOUNDS; i++) plain[i] = RiqLoadSoundFromWave(waves[i]);
+
+	Render expected;
+	expected.channels = RiqGetAudioDeviceInfo().channels;
+	RenderBankSounds(&expected, plain);
+
+	for (int i = 0; i < CHECK_BANK_SOUNDS; i++) RiqUnloadSound(plain[i]);
+
+	bool passed = RiqExportSoundBank(waves, names, CHECK_BANK_SOUNDS, CHECK_BANK_FILE);
+	if (!passed) *failure = "export failed";
+
+	if (passed)
+	{
+		SoundBank bank = RiqLoadSoundBank(CHECK_BANK_FILE);
+
+		Sound sounds[CHECK_BANK_SOUNDS];
+		for (int i = 0; i < CHECK_BANK_SOUNDS; i++) sounds[i] = RiqGetSoundBankSound(bank, names[i]);
+
+		if ((bank.soundCount != CHECK_BANK_SOUNDS) || (sounds[0].stream.buffer == NULL) || (sounds[1].stream.buffer == NULL) || (sounds[2].stream.buffer == NULL))
+		{
+			*failure = FormatFailure("bank loaded %i of %i sounds", (int)bank.soundCount, CHECK_BANK_SOUNDS);
+			passed = false;
+		}
+		else
+		{
+			Render actual;
+			actual.channels = expected.channels;
+			RenderBankSounds(&actual, sounds);
+
+			passed = CompareRenders(expected, actual, 0.0f, "bank render", failure);
+		}
+
+		RiqUnloadSoundBank(bank);
+	}
+
+	// Corrupted copies: a misaligned 16bit slice, an index running past the data offset, samples past the data block
+	std::vector<unsigned char> file;
+	if (passed && !LoadFileBytes(CHECK_BANK_FILE, &file))
+	{
+		*failure = "could not read the exported bank";
+		passed = false;
+	}
+
+	for (int corruption = 0; passed && (corruption < 3); corruption++)
+	{
+		std::vector<unsigned char> corrupted = file;
+		SoundBankHeader* header = (SoundBankHeader*)corrupted.data();
+		SoundBankEntry* entries = (SoundBankEntry*)(corrupted.data() + sizeof(SoundBankHeader));
+
+		switch (corruption)
+		{
+			case 0: entries[0].offset += 1; break;
+			case 1: header->soundCount = header->dataOffset; break;
+			case 2: entries[1].frameCount = header->dataSize; break;
+			default: break;
+		}
+
+		SoundBank bank = { 0 };
+		if (SaveFileBytes(CHECK_BANK_FILE, corrupted)) bank = RiqLoadSoundBank(CHECK_BANK_FILE);
+
+		if ((bank.soundCount != 0) || (bank.sounds != NULL))
+		{
+			*failure = FormatFailure("corrupted bank %i was loaded", corruption);
+			passed = false;
+		}
+
+		RiqUnloadSoundBank(bank);
+	}
+
+	remove(CHECK_BANK_FILE);
+	RiqCloseAudioDevice();
+
+	return passed;
+}
+
+#define CHECK_TRIM_LEAD_FRAMES      1500    // Silent frames around the trimmed source data
+#define CHECK_TRIM_DATA_FRAMES      3000
+
+typedef struct TrimCase
+{
+	int resampler;                  // Resampler both sounds play with: AudioResamplerQuality
+	float pitch;                    // Pitch both sounds play at
+	float tolerance;                // Max absolute error per sample between the two renders
+} TrimCase;
+
+// Plays one sound from the start with the case resampler and pitch, stopped afterwards so the next play restarts it
+static void RenderTrimCase(Render* render, Sound sound, const TrimCase* trimCase)
+{
+	QueueSoundCommand(AUDIO_COMMAND_SET_RESAMPLER, sound, (float)trimCase->resampler);
+	QueueSoundCommand(AUDIO_COMMAND_SET_PITCH, sound, trimCase->pitch);
+	QueueSoundCommand(AUDIO_COMMAND_PLAY, sound, 0.0f);
+	RiqSubmitCommands();
+
+	RenderFrames(render, 9600);
+
+	QueueSoundCommand(AUDIO_COMMAND_STOP, sound, 0.0f);
+	RiqSubmitCommands();
+}
+
+// Trimmed sound renders like the untrimmed one, leading silence played as a delay lands on the same frame
+static bool CheckTrimmedSound(std::string* failure)
+{
+	if (!InitCheckMixer(failure)) return false;
+
+	// Source at the device rate, so both loads convert the data the same way
+	std::vector<short> data;
+	GenerateSourceWave(SOURCE_TRIANGLE, GOLDEN_SAMPLE_RATE, CHECK_TRIM_DATA_FRAMES, 75, 0.5f, &data);
+
+	std::vector<short> samples((size_t)(CHECK_TRIM_DATA_FRAMES + 2 * CHECK_TRIM_LEAD_FRAMES) * 2, 0);
+	memcpy(samples.data() + CHECK_TRIM_LEAD_FRAMES * 2, data.data(), data.size() * sizeof(short));
+
+	Wave wave = { 0 };
+	wave.frameCount = CHECK_TRIM_DATA_FRAMES + 2 * CHECK_TRIM_LEAD_FRAMES;
+	wave.sampleRate = GOLDEN_SAMPLE_RATE;
+	wave.sampleSize = 16;
+	wave.channels = 2;
+	wave.data = samples.data();
+
+	// Direct resamplers start at the exact fractional position, so does the converter timer. The converter filter
+	// rings on past the data, that tail is cut with the trailing silence below the threshold
+	const TrimCase trimCases[] = {
+		{ AUDIO_RESAMPLER_LINEAR, 1.37f, 0.0f },
+		{ AUDIO_RESAMPLER_CUBIC, 0.8f, 0.0f },
+		{ AUDIO_RESAMPLER_CONVERTER, 1.0f, 1e-3f },
+		{ AUDIO_RESAMPLER_CONVERTER, 0.7f, 1e-3f },
+		{ AUDIO_RESAMPLER_CONVERTER, 1.37f, 1e-3f },
+	};
+
+	bool passed = true;
+
+	// Sounds are loaded again for every case, the converter keeps its state from one play to the next
+	for (int i = 0; passed && (i < (int)(sizeof(trimCases) / sizeof(trimCases[0]))); i++)
+	{
+		Sound plain = RiqLoadSoundFromWave(wave);
+		Sound trimmed = RiqLoadSoundFromWaveTrimmed(wave, -60.0f);
+
+		if (RiqGetSoundTrimOffset(trimmed) == 0)
+		{
+			*failure = "leading silence was not trimmed";
+			passed = false;
+		}
+		else
+		{
+			Render expected;
+			expected.channels = RiqGetAudioDeviceInfo().channels;
+			RenderTrimCase(&expected, plain, &trimCases[i]);
+
+			Render actual;
+			actual.channels = expected.channels;
+			RenderTrimCase(&actual, trimmed, &trimCases[i]);
+
+			std::string what = FormatFailure("resampler %i pitch %g", trimCases[i].resampler, trimCases[i].pitch);
+			passed = CompareRenders(expected, actual, trimCases[i].tolerance, what.c_str(), failure);
+		}
+
+		RiqUnloadSound(plain);
+		RiqUnloadSound(trimmed);
+	}
+
+	RiqCloseAudioDevice();
+
+	return passed;
+}
+
+// Calibration on the null backend finds every synthetic loopback delay exactly, then gives the playback device back
+static bool CheckLatencyCalibration(std::string* failure)
+{
+	AudioDeviceOptions options = RiqGetDefaultAudioDeviceOptions();
+	options.sampleRate = GOLDEN_SAMPLE_RATE;
+	options.layout = AUDIO_LAYOUT_STEREO;
+	options.backend = ma_backend_null;
+
+	RiqInitAudioDeviceEx(options);
+	if (!IsRiqReady())
+	{
+		*failure = "null backend device did not start";
+		return false;
+	}
+
+	// Null backend runs in real time, a short click train keeps the check quick
+	const unsigned int delays[] = { 1234, 480, 3001 };
+	bool passed = true;
+
+	for (int i = 0; passed && (i < (int)(sizeof(delays) / sizeof(delays[0]))); i++)
+	{
+		AudioCalibrationOptions calibrationOptions = RiqGetDefaultAudioCalibrationOptions();
+		calibrationOptions.clickCount = 4;
+		calibrationOptions.clickIntervalMs = 60;
+		calibrationOptions.maxLatencyMs = 100;
+		calibrationOptions.syntheticLoopbackFrames = delays[i];
+
+		AudioLatencyCalibration calibration = RiqCalibrateAudioLatency(calibrationOptions);
+
+		if (!calibration.success || (calibration.roundTripFrames != delays[i]) || (fabsf(calibration.confidence - 1.0f) > 1e-3f))
+		{
+			*failure = FormatFailure("delay %i: round trip %i frames, confidence %g", (int)delays[i], (int)calibration.roundTripFrames, calibration.confidence);
+			passed = false;
+		}
+		else if (!IsRiqReady())
+		{
+			*failure = FormatFailure("delay %i: playback device was not restored", (int)delays[i]);
+			passed = false;
+		}
+	}
+
+	if (IsRiqReady()) RiqCloseAudioDevice();
+
+	return passed;
+}
+
+#define CHECK_SPECTRUM_BIN          32      // Sine bin, a whole number of periods per FFT and meter window
+
+// Full scale sine on a mono mix reads 1.0 on its spectrum bin, master meter reads its peak and RMS
+static bool CheckMeterSpectrum(std::string* failure)
+{
+	AudioDeviceOptions options = RiqGetDefaultAudioDeviceOptions();
+	options.sampleRate = GOLDEN_SAMPLE_RATE;
+	options.layout = AUDIO_LAYOUT_MONO;
+
+	RiqInitAudioOfflineEx(options);
+	if (!IsRiqReady())
+	{
+		*failure = "offline mixer did not start";
+		return false;
+	}
+
+	// Mono source is fed at unity to a mono output, the direct resampler copies it as is at pitch 1.0
+	const unsigned int period = AUDIO_SPECTRUM_SIZE / CHECK_SPECTRUM_BIN;
+	std::vector<float> samples(2 * GOLDEN_SAMPLE_RATE);
+	for (size_t i = 0; i < samples.size(); i++) samples[i] = sinf(2.0f * 3.14159265f * (float)(i % period) / (float)period);
+
+	Wave wave = { 0 };
+	wave.frameCount = (unsigned int)samples.size();
+	wave.sampleRate = GOLDEN_SAMPLE_RATE;
+	wave.sampleSize = 32;
+	wave.channels = 1;
+	wave.data = samples.data();
+
+	Sound sine = RiqLoadSoundFromWave(wave);
+
+	RiqEnableSpectrum(true);
+
+	QueueSoundCommand(AUDIO_COMMAND_SET_RESAMPLER, sine, (float)AUDIO_RESAMPLER_LINEAR);
+	QueueSoundCommand(AUDIO_COMMAND_PLAY, sine, 0.0f);
+	RiqSubmitCommands();
+
+	Render render;
+	render.channels = RiqGetAudioDeviceInfo().channels;
+	RenderFrames(&render, 9600);
+
+	bool passed = true;
+
+	// Last window is all sine, 32 whole periods
+	AudioMeterLevels levels = RiqGetMasterMeter();
+	if ((levels.sequence == 0) || (levels.channels != 1) || (fabsf(levels.peak[0] - 1.0f) > 1e-3f) || (fabsf(levels.rms[0] - 0.70710678f) > 1e-3f))
+	{
+		*failure = FormatFailure("master meter read peak %g rms %g (snapshot %i)", levels.peak[0], levels.rms[0], (int)levels.sequence);
+		passed = false;
+	}
+
+	// Spectrum thread runs on its own schedule and only on new samples, the mix keeps going while it is polled
+	float magnitudes[AUDIO_SPECTRUM_SIZE / 2] = { 0 };
+
+	for (int tries = 0; passed && (tries < 100); tries++)
+	{
+		if ((RiqGetSpectrum(magnitudes, AUDIO_SPECTRUM_SIZE / 2) > 0) && (fabsf(magnitudes[CHECK_SPECTRUM_BIN] - 1.0f) <= 1e-3f)) break;
+
+		RenderFrames(&render, GOLDEN_BLOCK_FRAMES);
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+
+	if (passed && ((fabsf(magnitudes[CHECK_SPECTRUM_BIN] - 1.0f) > 1e-3f) || (magnitudes[CHECK_SPECTRUM_BIN * 3] > 1e-3f)))
+	{
+		*failure = FormatFailure("spectrum read %g on the sine bin, %g on bin %i", magnitudes[CHECK_SPECTRUM_BIN], magnitudes[CHECK_SPECTRUM_BIN * 3], CHECK_SPECTRUM_BIN * 3);
+		passed = false;
+	}
+
+	RiqEnableSpectrum(false);
+	RiqUnloadSound(sine);
+	RiqCloseAudioDevice();
+
+	return passed;
+}
+
+static const Check checks[] = {
+	{ "sound_bank", CheckSoundBank },
+	{ "trimmed_sound", CheckTrimmedSound },
+	{ "latency_calibration", CheckLatencyCalibration },
+	{ "meter_spectrum", CheckMeterSpectrum },
+};
+
+// ================================================================================
+#pragma endregion
+// ================================================================================
+
+// ================================================================================
+#pragma region Golden Files
+// ================================================================================
+
+static bool LoadGolden(const std::string& fileName, std::vector<float>* frames)
+{
+	FILE* file = fopen(fileName.c_str(), "rb");
+	if (file == NULL) return false;
+
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	frames->resize((size > 0) ? (size_t)size / sizeof(float) : 0);
+	size_t count = fread(frames->data(), sizeof(float), frames->size(), file);
+	fclose(file);
+
+	return (count == frames->size());
+}
+
+static bool SaveGolden(const std::string& fileName, const std::vector<float>& frames)
+{
+	FILE* file = fopen(fileName.c_str(), "wb");
+	if (file == NULL) return false;
+
+	size_t count = fwrite(frames.data(), sizeof(float), frames.size(), file);
+	fclose(file);
+
+	return (count == frames.size());
+}
+
+// Compares a render with its golden, exact on scalar builds and within GOLDEN_SIMD_TOLERANCE otherwise
+static bool CompareGolden(const Render& render, const std::vector<float>& golden, float* maxError, size_t* firstMismatch)
+{
+	*maxError = 0.0f;
+	*firstMismatch = 0;
+
+	if (render.frames.size() != golden.size()) return false;
+
+#if defined(RIQ_NO_SIMD)
+	const float tolerance = 0.0f;
+#else
+	const float tolerance = GOLDEN_SIMD_TOLERANCE;
+#endif
+
+	bool match = true;
+
+	for (size_t i = 0; i < golden.size(); i++)
+	{
+		float error = fabsf(render.frames[i] - golden[i]);
+
+		// Exact mode compares bits, so -0.0 or a NaN never passes as equal
+		bool equal = (tolerance > 0.0f) ? (error <= tolerance) : (memcmp(&render.frames[i], &golden[i], sizeof(float)) == 0);
+
+		if (error > *maxError) *maxError = error;
+		if (!equal && match)
+		{
+			*firstMismatch = i;
+			match = false;
+		}
+	}
+
+	return match;
+}
+
+// ================================================================================
+#pragma endregion
+// ================================================================================
+
+int main(int argc, char** argv)
+{
+	bool update = false;
+	std::string goldenDir = "golden";
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--update") == 0) update = true;
+		else goldenDir = argv[i];
+	}
+
+	LoadConsoleLog();
+
+	int failed = 0;
+	const int scenarioCount = (int)(sizeof(scenarios) / sizeof(scenarios[0]));
+
+	for (int i = 0; i < scenarioCount; i++)
+	{
+		const Scenario* scenario = &scenarios[i];
+		const std::string fileName = goldenDir + "/" + scenario->name + ".f32";
+
+		AudioDeviceOptions options = RiqGetDefaultAudioDeviceOptions();
+		options.sampleRate = GOLDEN_SAMPLE_RATE;
+		options.layout = scenario->layout;
+
+		RiqInitAudioOfflineEx(options);
+		if (!IsRiqReady())
+		{
+			printf("[FAIL] %s: offline mixer did not start\n", scenario->name);
+			failed++;
+			continue;
+		}
+
+		Render render;
+		render.channels = RiqGetAudioDeviceInfo().channels;
+
+		randomSeed = 0x52495132 + (unsigned int)i;
+		scenario->run(&render);
+
+		RiqCloseAudioDevice();
+
+		if (update)
+		{
+			bool saved = SaveGolden(fileName, render.frames);
+			printf("[%s] %s: %i frames\n", saved ? "SAVED" : "FAIL", fileName.c_str(), (int)(render.frames.size() / render.channels));
+			if (!saved) failed++;
+			continue;
+		}
+
+		std::vector<float> golden;
+		if (!LoadGolden(fileName, &golden))
+		{
+			printf("[FAIL] %s: could not read %s\n", scenario->name, fileName.c_str());
+			failed++;
+			continue;
+		}
+
+		float maxError = 0.0f;
+		size_t firstMismatch = 0;
+
+		if (CompareGolden(render, golden, &maxError, &firstMismatch)) printf("[ OK ] %s (max error %g)\n", scenario->name, maxError);
+		else
+		{
+			if (render.frames.size() != golden.size()) printf("[FAIL] %s: %i samples rendered, golden has %i\n", scenario->name, (int)render.frames.size(), (int)golden.size());
+			else printf("[FAIL] %s: frame %i channel %i differs, max error %g\n", scenario->name, (int)(firstMismatch / render.channels), (int)(firstMismatch % render.channels), maxError);
+
+			failed++;
+		}
+	}
+
+	printf("%i of %i scenarios passed\n", scenarioCount - failed, scenarioCount);
+
+	int checksFailed = 0;
+	const int checkCount = (int)(sizeof(checks) / sizeof(checks[0]));
+
+	for (int i = 0; i < checkCount; i++)
+	{
+		std::string failure;
+
+		randomSeed = 0x43484b30 + (unsigned int)i;
+
+		if (checks[i].run(&failure)) printf("[ OK ] %s\n", checks[i].name);
+		else
+		{
+			printf("[FAIL] %s: %s\n", checks[i].name, failure.c_str());
+			checksFailed++;
+		}
+
+		if (IsRiqReady()) RiqCloseAudioDevice();
+	}
+
+	UnloadConsoleLog();
+
+	printf("%i of %i checks passed\n", checkCount - checksFailed, checkCount);
+
+	return ((failed == 0) && (checksFailed == 0)) ? 0 : 1;
+}
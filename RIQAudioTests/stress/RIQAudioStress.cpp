@@ -0,0 +1,317 @@
+// Stress and soak harness, game side threads hammer the library while the offline mixer renders
+//
+// Usage: RIQAudioStress [--players N] [--loaders N] [--seconds S] [--unpaced] [--scale]
+//
+// Loaders load, play, stretch, attach effects to and unload their own sounds. Players play, meter and
+// re-route a shared set of sounds, tweak shared effects attached for the whole run and attach and detach
+// their own effects (an effect runs on one chain at a time). A commander owns the command buffer and sends
+// play/stop/pause/resume/pitch/volume/pan to shared and loader sounds by handle, stale handles included.
+// Spectrum analysis runs on its own thread meanwhile. The mixer renders 10ms blocks at realtime pace
+// (or as fast as it can with --unpaced).
+// Reports operations per second and callback times, --scale repeats the run doubling players up to N.
+// NOTE: Meant to be run in the TSan configuration too, any report there is a library bug
+
+#include "RIQAudio.hpp"
+#include "ConsoleLog.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#define STRESS_SAMPLE_RATE          48000
+#define STRESS_BLOCK_FRAMES         480     // Frames rendered per mixing callback, a 10ms device period
+#define STRESS_SHARED_SOUNDS        16      // Sounds loaded up front, played by every player
+#define STRESS_SHARED_EFFECTS       4       // Effects tweaked by every player, attached to sounds and the final mix for the whole run
+#define STRESS_MAX_LOADERS          64      // Loader handle slots visible to the commander
+#define STRESS_SOURCE_FRAMES        12000   // Source frames, longer than any sound sliced from it
+
+typedef struct StressOptions
+{
+	int players;                    // Player threads
+	int loaders;                    // Loader threads
+	double seconds;                 // Run length
+	bool paced;                     // Render at realtime pace, like a device would pull
+} StressOptions;
+
+typedef struct StressResult
+{
+	unsigned long long ops;         // Library calls made by game side threads
+	unsigned long long blocks;      // Blocks rendered
+	double seconds;                 // Measured run length
+	AudioMixerStats stats;          // Mixer statistics over the run
+} StressResult;
+
+static std::atomic<bool> running(false);
+static std::atomic<unsigned long long> totalOps(0);
+
+static Sound sharedSounds[STRESS_SHARED_SOUNDS];
+static AudioEffect* sharedEffects[STRESS_SHARED_EFFECTS];
+static std::atomic<unsigned int> loaderHandles[STRESS_MAX_LOADERS];
+
+static std::vector<short> sourceSamples;
+
+static unsigned int NextRandom(unsigned int* seed)
+{
+	*seed = *seed * 1664525u + 1013904223u;
+
+	return *seed >> 8;
+}
+
+static Sound LoadStressSound(unsigned int frameCount, unsigned int sampleRate)
+{
+	Wave wave = { 0 };
+	wave.frameCount = frameCount;
+	wave.sampleRate = sampleRate;
+	wave.sampleSize = 16;
+	wave.channels = 2;
+	wave.data = sourceSamples.data();
+
+	return RiqLoadSoundFromWave(wave);
+}
+
+// ================================================================================
+#pragma region Game Threads
+// ================================================================================
+
+static void RunLoader(int index)
+{
+	unsigned int seed = 0x4c4f4144 + (unsigned int)index;
+	unsigned long long ops = 0;
+
+	AudioEffect* eq = RiqLoadEffectEQ(1);
+
+	while (running.load(std::memory_order_relaxed))
+	{
+		Sound sound = LoadStressSound(2000 + NextRandom(&seed) % 6000, ((NextRandom(&seed) & 1) != 0) ? 44100 : 48000);
+		loaderHandles[index].store(RiqGetSoundHandle(sound));
+
+		const bool filtered = ((NextRandom(&seed) & 3) == 0);
+		if (filtered) RiqAttachSoundEffect(sound, eq);
+
+		for (int i = 0; i < 4; i++)
+		{
+			RiqPlaySound(sound);
+			if ((NextRandom(&seed) & 1) != 0) RiqSetSoundTempo(sound, 0.5f + (float)(NextRandom(&seed) % 100) / 50.0f);
+			RiqGetSoundSourcePosition(sound);
+			RiqSetEffectEQStage(eq, 0, BIQUAD_LOWPASS, 500.0f + (float)(NextRandom(&seed) % 8000), 0.7071f, 0.0f);
+			ops += 4;
+
+			std::this_thread::sleep_for(std::chrono::microseconds(NextRandom(&seed) % 500));
+		}
+
+		loaderHandles[index].store(0);
+
+		if (filtered) RiqDetachSoundEffect(sound, eq);
+		RiqUnloadSound(sound);
+		ops += 3;
+	}
+
+	RiqUnloadEffect(eq);
+	totalOps += ops;
+}
+
+static void RunPlayer(int index)
+{
+	unsigned int seed = 0x504c4159 + (unsigned int)index;
+	unsigned long long ops = 0;
+
+	float magnitudes[AUDIO_SPECTRUM_SIZE / 2];
+
+	AudioEffect* effect = ((index & 1) != 0) ? RiqLoadEffectLimiter(-12.0f, 2.0f, 50.0f) : RiqLoadEffectEQ(2);
+
+	while (running.load(std::memory_order_relaxed))
+	{
+		Sound sound = sharedSounds[NextRandom(&seed) % STRESS_SHARED_SOUNDS];
+		float value = (float)(NextRandom(&seed) % 1000) / 1000.0f;
+
+		switch (NextRandom(&seed) % 10)
+		{
+			case 0: RiqPlaySound(sound); break;
+			case 1: RiqSetSoundResampler(sound, (int)(NextRandom(&seed) % 3)); break;
+			case 2: RiqGetSoundSourcePosition(sound); break;
+			case 3: RiqGetSoundMeter(sound); RiqGetMasterMeter(); RiqGetSpectrum(magnitudes, AUDIO_SPECTRUM_SIZE / 2); break;
+			case 4: if (RiqAttachSoundEffect(sound, effect)) RiqDetachSoundEffect(sound, effect); break;
+			case 5: if (RiqAttachMixedEffect(effect)) RiqDetachMixedEffect(effect); break;
+			case 6: RiqSetEffectEQStage(sharedEffects[0], 0, BIQUAD_PEAK, 200.0f + value * 4000.0f, 1.0f, value * 6.0f); break;
+			case 7: RiqSetEffectReverb(sharedEffects[1], value, 0.5f, value * 0.5f); break;
+			case 8: RiqSetEffectLimiter(sharedEffects[2], -6.0f - value * 12.0f, 20.0f + value * 100.0f); break;
+			case 9: if ((NextRandom(&seed) & 1) != 0) RiqEnableSoundMeter(sound); else RiqDisableSoundMeter(sound); break;
+			default: break;
+		}
+
+		ops++;
+		if ((ops & 63) == 0) std::this_thread::yield();
+	}
+
+	RiqUnloadEffect(effect);
+	totalOps += ops;
+}
+
+// Command buffer is written by a single thread, it targets shared and loader sounds by handle
+static void RunCommander(int loaderCount)
+{
+	unsigned int seed = 0x434d4453;
+	unsigned long long ops = 0;
+
+	AudioCommandBuffer* commandBuffer = RiqGetCommandBuffer();
+
+	while (running.load(std::memory_order_relaxed))
+	{
+		for (int i = 0; (i < 32) && (commandBuffer->count < commandBuffer->capacity); i++)
+		{
+			AudioCommand* command = &commandBuffer->commands[commandBuffer->count++];
+			unsigned int target = NextRandom(&seed) % (STRESS_SHARED_SOUNDS + loaderCount);
+
+			command->handle = (target < STRESS_SHARED_SOUNDS) ? RiqGetSoundHandle(sharedSounds[target]) : loaderHandles[target - STRESS_SHARED_SOUNDS].load();
+			command->type = NextRandom(&seed) % (AUDIO_COMMAND_SET_PAN + 1);
+			command->value = 0.25f + (float)(NextRandom(&seed) % 1000) / 1000.0f;
+		}
+
+		RiqSubmitCommands();
+		ops += 32;
+
+		std::this_thread::sleep_for(std::chrono::microseconds(200));
+	}
+
+	totalOps += ops;
+}
+
+// ================================================================================
+#pragma endregion
+// ================================================================================
+
+static StressResult RunStress(StressOptions options)
+{
+	StressResult result = { 0 };
+
+	RiqInitAudioOffline(STRESS_SAMPLE_RATE);
+	if (!IsRiqReady()) return result;
+
+	for (int i = 0; i < STRESS_SHARED_SOUNDS; i++)
+	{
+		sharedSounds[i] = LoadStressSound(4000 + i * 500, (i & 1) ? 44100 : 48000);
+		sharedSounds[i].stream.buffer->looping = ((i % 4) == 0);
+	}
+
+	sharedEffects[0] = RiqLoadEffectEQ(1);
+	sharedEffects[1] = RiqLoadEffectReverb(0.5f, 0.5f, 0.3f);
+	sharedEffects[2] = RiqLoadEffectLimiter(-6.0f, 2.0f, 50.0f);
+	sharedEffects[3] = RiqLoadEffectLowPass(4000.0f);
+
+	RiqAttachSoundEffect(sharedSounds[0], sharedEffects[0]);
+	RiqAttachSoundEffect(sharedSounds[1], sharedEffects[1]);
+	RiqAttachMixedEffect(sharedEffects[2]);
+	RiqAttachSoundEffect(sharedSounds[2], sharedEffects[3]);
+
+	for (int i = 0; i < STRESS_MAX_LOADERS; i++) loaderHandles[i].store(0);
+
+	RiqEnableSpectrum(true);
+
+	totalOps = 0;
+	running = true;
+
+	std::vector<std::thread> threads;
+	for (int i = 0; i < options.loaders; i++) threads.emplace_back(RunLoader, i);
+	for (int i = 0; i < options.players; i++) threads.emplace_back(RunPlayer, i);
+	threads.emplace_back(RunCommander, options.loaders);
+
+	std::vector<float> block((size_t)STRESS_BLOCK_FRAMES * RiqGetAudioDeviceInfo().channels);
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	const std::chrono::microseconds period((long long)STRESS_BLOCK_FRAMES * 1000000 / STRESS_SAMPLE_RATE);
+
+	RiqResetMixerStats();
+
+	while (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() < options.seconds)
+	{
+		RiqRenderAudio(block.data(), STRESS_BLOCK_FRAMES);
+		result.blocks++;
+
+		if (options.paced) std::this_thread::sleep_until(start + period * result.blocks);
+	}
+
+	running = false;
+	for (std::thread& thread : threads) thread.join();
+
+	result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	result.ops = totalOps.load();
+	result.stats = RiqGetMixerStats();
+
+	RiqEnableSpectrum(false);
+
+	// Sounds go first, their effects are detached with them and free to unload
+	for (int i = 0; i < STRESS_SHARED_SOUNDS; i++) RiqUnloadSound(sharedSounds[i]);
+	for (int i = 0; i < STRESS_SHARED_EFFECTS; i++) RiqUnloadEffect(sharedEffects[i]);
+
+	RiqCloseAudioDevice();
+
+	return result;
+}
+
+static void PrintResult(const StressOptions& options, const StressResult& result)
+{
+	printf("players %2i loaders %2i | %10.0f ops/s | %6.0f blocks/s | callback avg %.3f ms worst %.3f ms | worst load %.2f overruns %u | max buffers %u\n",
+		options.players, options.loaders, (double)result.ops / result.seconds, (double)result.blocks / result.seconds,
+		result.stats.averageCallbackMs, result.stats.worstCallbackMs, result.stats.worstLoad, result.stats.overruns, result.stats.maxBuffersMixed);
+}
+
+int main(int argc, char** argv)
+{
+	StressOptions options = { 4, 2, 10.0, true };
+	bool scale = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if ((strcmp(argv[i], "--players") == 0) && (i + 1 < argc)) options.players = atoi(argv[++i]);
+		else if ((strcmp(argv[i], "--loaders") == 0) && (i + 1 < argc)) options.loaders = atoi(argv[++i]);
+		else if ((strcmp(argv[i], "--seconds") == 0) && (i + 1 < argc)) options.seconds = atof(argv[++i]);
+		else if (strcmp(argv[i], "--unpaced") == 0) options.paced = false;
+		else if (strcmp(argv[i], "--scale") == 0) scale = true;
+		else
+		{
+			printf("Usage: RIQAudioStress [--players N] [--loaders N] [--seconds S] [--unpaced] [--scale]\n");
+			return 1;
+		}
+	}
+
+	if (options.players < 0) options.players = 0;
+	if (options.loaders < 0) options.loaders = 0;
+	if (options.loaders > STRESS_MAX_LOADERS) options.loaders = STRESS_MAX_LOADERS;
+
+	LoadConsoleLog();
+
+	// Seeded source data, every sound is a slice of it
+	unsigned int seed = 0x53545253;
+	sourceSamples.resize(STRESS_SOURCE_FRAMES * 2);
+	for (size_t i = 0; i < sourceSamples.size(); i++) sourceSamples[i] = (short)((int)(NextRandom(&seed) % 8192) - 4096);
+
+	int failed = 0;
+	int players = scale ? ((options.players > 0) ? 1 : 0) : options.players;
+
+	while (true)
+	{
+		StressOptions run = options;
+		run.players = players;
+
+		StressResult result = RunStress(run);
+		if (result.blocks == 0)
+		{
+			printf("Offline mixer did not start\n");
+			failed++;
+			break;
+		}
+
+		PrintResult(run, result);
+
+		if (!scale || (players >= options.players)) break;
+		players = (players * 2 < options.players) ? players * 2 : options.players;
+	}
+
+	UnloadConsoleLog();
+
+	return (failed == 0) ? 0 : 1;
+}
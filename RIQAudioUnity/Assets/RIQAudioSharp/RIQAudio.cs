@@ -3,10 +3,53 @@ using System.Runtime.InteropServices;
 
 namespace RIQAudioUnity
 {
+    /// <summary>Processes a block of interleaved float frames in place, called from the audio thread</summary>
+    [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+    public unsafe delegate void AudioProcessorCallback(IntPtr context, float* frames, uint frameCount, uint channels, uint sampleRate);
+
     public static unsafe class RIQAudio
     {
         [DllImport("RIQAudio")]
         public static extern void RiqInitAudioDevice();
+        /// <summary>Initialize audio device with custom buffering options</summary>
+        [DllImport("RIQAudio")]
+        public static extern void RiqInitAudioDeviceEx(AudioDeviceOptions options);
+        /// <summary>Get default audio device options, same ones used by RiqInitAudioDevice()</summary>
+        [DllImport("RIQAudio")]
+        public static extern AudioDeviceOptions RiqGetDefaultAudioDeviceOptions();
+        /// <summary>Get values negotiated with the backend and estimated output latency</summary>
+        [DllImport("RIQAudio")]
+        public static extern AudioDeviceInfo RiqGetAudioDeviceInfo();
+        /// <summary>Get mixing callback statistics: callback times, overruns and buffers mixed</summary>
+        [DllImport("RIQAudio")]
+        public static extern AudioMixerStats RiqGetMixerStats();
+        /// <summary>Reset mixing callback statistics</summary>
+        [DllImport("RIQAudio")]
+        public static extern void RiqResetMixerStats();
+        /// <summary>Initialize audio system without a running device, the mix is pulled with RiqRenderAudio() (deterministic, for headless tests)</summary>
+        [DllImport("RIQAudio")]
+        public static extern void RiqInitAudioOffline(uint sampleRate);
+        /// <summary>Initialize audio system without a running device using the given options, the backend is always null</summary>
+        [DllImport("RIQAudio")]
+        public static extern void RiqInitAudioOfflineEx(AudioDeviceOptions options);
+
+        [DllImport("RIQAudio")]
+        private static extern uint RiqRenderAudio(float* framesOut, uint frameCount);
+        /// <summary>Mix the next frames into framesOut (interleaved, device channels), offline mode only, never call it from two threads at once</summary>
+        public static uint RiqRenderAudio(float[] framesOut, uint channels)
+        {
+            fixed (float* framesOutNative = framesOut)
+            {
+                return RiqRenderAudio(framesOutNative, (uint)framesOut.Length / channels);
+            }
+        }
+
+        /// <summary>Get default latency calibration options</summary>
+        [DllImport("RIQAudio")]
+        public static extern AudioCalibrationOptions RiqGetDefaultAudioCalibrationOptions();
+        /// <summary>Measure output latency playing a click train through a duplex device, blocking (game audio is muted while it runs)</summary>
+        [DllImport("RIQAudio")]
+        public static extern AudioLatencyCalibration RiqCalibrateAudioLatency(AudioCalibrationOptions options);
         [DllImport("RIQAudio")]
         public static extern void RiqCloseAudioDevice();
         [DllImport("RIQAudio")]
@@ -24,10 +67,169 @@ namespace RIQAudioUnity
 
         [DllImport("RIQAudio")]
         public static extern Sound RiqLoadSoundFromWave(Wave wave);
+
+        [DllImport("RIQAudio")]
+        private static extern Sound RiqLoadSoundTrimmed(sbyte* filePath, float thresholdDb);
+        /// <summary>Load sound from file with leading and trailing silence below thresholdDb removed, leading silence plays as a delay, inner spans below thresholdDb are skipped by direct resamplers (not bit-exact)</summary>
+        public static Sound RiqLoadSoundTrimmed(string filePath, float thresholdDb)
+        {
+            using var str1 = filePath.ToAnsiBuffer();
+            return RiqLoadSoundTrimmed(str1.AsPointer(), thresholdDb);
+        }
+
+        /// <summary>Load sound from wave with leading and trailing silence below thresholdDb removed, leading silence plays as a delay, inner spans below thresholdDb are skipped by direct resamplers (not bit-exact)</summary>
+        [DllImport("RIQAudio")]
+        public static extern Sound RiqLoadSoundFromWaveTrimmed(Wave wave, float thresholdDb);
+        /// <summary>Get leading silence frames trimmed at load, in sound frames</summary>
+        [DllImport("RIQAudio")]
+        public static extern uint RiqGetSoundTrimOffset(Sound sound);
         [DllImport("RIQAudio")]
         public static extern void RiqUnloadSound(Sound sound);
         [DllImport("RIQAudio")]
         public static extern void RiqPlaySound(Sound sound);
+        /// <summary>Get sound handle, used to address the sound from the command buffer</summary>
+        [DllImport("RIQAudio")]
+        public static extern uint RiqGetSoundHandle(Sound sound);
+        /// <summary>Set sound tempo, changes speed without changing pitch (1.0f is normal speed)</summary>
+        [DllImport("RIQAudio")]
+        public static extern void RiqSetSoundTempo(Sound sound, float tempo);
+        /// <summary>Get current source position in frames, exact under any tempo, useful for chart sync</summary>
+        [DllImport("RIQAudio")]
+        public static extern double RiqGetSoundSourcePosition(Sound sound);
+        /// <summary>Set sound resampler, direct resamplers skip the data converter on static float sounds but have no anti-aliasing filter (default is Converter)</summary>
+        [DllImport("RIQAudio")]
+        public static extern void RiqSetSoundResampler(Sound sound, AudioResamplerQuality resampler);
+
+        [DllImport("RIQAudio")]
+        private static extern SoundBank RiqLoadSoundBank(sbyte* filePath);
+        /// <summary>Load sound bank from file, all sounds share one contiguous samples block</summary>
+        public static SoundBank RiqLoadSoundBank(string filePath)
+        {
+            using var str1 = filePath.ToAnsiBuffer();
+            return RiqLoadSoundBank(str1.AsPointer());
+        }
+
+        /// <summary>Unload sound bank and all its sounds</summary>
+        [DllImport("RIQAudio")]
+        public static extern void RiqUnloadSoundBank(SoundBank bank);
+
+        [DllImport("RIQAudio")]
+        private static extern int RiqGetSoundBankIndex(SoundBank bank, sbyte* name);
+        /// <summary>Get sound index in the bank by name, -1 if not found</summary>
+        public static int RiqGetSoundBankIndex(SoundBank bank, string name)
+        {
+            using var str1 = name.ToAnsiBuffer();
+            return RiqGetSoundBankIndex(bank, str1.AsPointer());
+        }
+
+        [DllImport("RIQAudio")]
+        private static extern Sound RiqGetSoundBankSound(SoundBank bank, sbyte* name);
+        /// <summary>Get sound from the bank by name, owned by the bank (do not unload it)</summary>
+        public static Sound RiqGetSoundBankSound(SoundBank bank, string name)
+        {
+            using var str1 = name.ToAnsiBuffer();
+            return RiqGetSoundBankSound(bank, str1.AsPointer());
+        }
+
+        /// <summary>Get sound from the bank by index, owned by the bank (do not unload it)</summary>
+        public static Sound RiqGetSoundBankSound(SoundBank bank, int index)
+        {
+            return bank.Sounds[index];
+        }
+
+        /// <summary>Attach processor to sound, the delegate must be kept alive while attached</summary>
+        [DllImport("RIQAudio")]
+        public static extern bool RiqAttachSoundProcessor(Sound sound, AudioProcessorCallback process, IntPtr context);
+        /// <summary>Detach processor, returns once the audio thread is done with it so the delegate and context can be released</summary>
+        [DllImport("RIQAudio")]
+        public static extern void RiqDetachSoundProcessor(Sound sound, AudioProcessorCallback process, IntPtr context);
+        /// <summary>Attach processor to the final mix, the delegate must be kept alive while attached</summary>
+        [DllImport("RIQAudio")]
+        public static extern bool RiqAttachMixedProcessor(AudioProcessorCallback process, IntPtr context);
+        /// <summary>Detach processor, returns once the audio thread is done with it so the delegate and context can be released</summary>
+        [DllImport("RIQAudio")]
+        public static extern void RiqDetachMixedProcessor(AudioProcessorCallback process, IntPtr context);
+
+        /// <summary>Load cascaded biquad EQ, every stage starts flat</summary>
+        [DllImport("RIQAudio")]
+        public static extern IntPtr RiqLoadEffectEQ(int stageCount);
+        /// <summary>Load low-pass filter, i.e. for muffled game states</summary>
+        [DllImport("RIQAudio")]
+        public static extern IntPtr RiqLoadEffectLowPass(float cutoff);
+        /// <summary>Load look-ahead limiter, lookahead is fixed at creation for the current device</summary>
+        [DllImport("RIQAudio")]
+        public static extern IntPtr RiqLoadEffectLimiter(float thresholdDb, float lookaheadMs, float releaseMs);
+        /// <summary>Load low-cost Schroeder reverb, all parameters go from 0.0f to 1.0f</summary>
+        [DllImport("RIQAudio")]
+        public static extern IntPtr RiqLoadEffectReverb(float roomSize, float damping, float wet);
+        [DllImport("RIQAudio")]
+        public static extern void RiqSetEffectEQStage(IntPtr effect, int stage, BiquadType type, float frequency, float q, float gainDb);
+        [DllImport("RIQAudio")]
+        public static extern void RiqSetEffectLimiter(IntPtr effect, float thresholdDb, float releaseMs);
+        [DllImport("RIQAudio")]
+        public static extern void RiqSetEffectReverb(IntPtr effect, float roomSize, float damping, float wet);
+        /// <summary>Unload effect, it is detached from the final mix, unloading is refused (nothing changes) while it is attached to a sound (memory is released once the mixer is done with it)</summary>
+        [DllImport("RIQAudio")]
+        public static extern void RiqUnloadEffect(IntPtr effect);
+        /// <summary>Attach effect to a sound, an effect runs on one chain (sound or final mix) at a time, attach fails if it is already attached</summary>
+        [DllImport("RIQAudio")]
+        public static extern bool RiqAttachSoundEffect(Sound sound, IntPtr effect);
+        [DllImport("RIQAudio")]
+        public static extern void RiqDetachSoundEffect(Sound sound, IntPtr effect);
+        /// <summary>Attach effect to the final mix, fails if it is already attached to a sound or the final mix</summary>
+        [DllImport("RIQAudio")]
+        public static extern bool RiqAttachMixedEffect(IntPtr effect);
+        [DllImport("RIQAudio")]
+        public static extern void RiqDetachMixedEffect(IntPtr effect);
+
+        /// <summary>Get latest master meter snapshot, lock-free</summary>
+        [DllImport("RIQAudio")]
+        public static extern AudioMeterLevels RiqGetMasterMeter();
+        /// <summary>Enable level metering of a sound</summary>
+        [DllImport("RIQAudio")]
+        public static extern bool RiqEnableSoundMeter(Sound sound);
+        [DllImport("RIQAudio")]
+        public static extern void RiqDisableSoundMeter(Sound sound);
+        /// <summary>Get latest sound meter snapshot, lock-free</summary>
+        [DllImport("RIQAudio")]
+        public static extern AudioMeterLevels RiqGetSoundMeter(Sound sound);
+        /// <summary>Start or stop the spectrum thread, an FFT of the final mix is published every few milliseconds</summary>
+        [DllImport("RIQAudio")]
+        public static extern void RiqEnableSpectrum(bool enable);
+
+        [DllImport("RIQAudio")]
+        private static extern int RiqGetSpectrum(float* magnitudesOut, int binCount);
+        /// <summary>Get latest spectrum magnitudes (full scale sine reads 1.0), lock-free, returns bins written</summary>
+        public static int RiqGetSpectrum(float[] magnitudesOut)
+        {
+            fixed (float* magnitudesOutNative = magnitudesOut)
+            {
+                return RiqGetSpectrum(magnitudesOutNative, magnitudesOut.Length);
+            }
+        }
+
+        /// <summary>Get native command buffer, commands are written in place and applied on RiqSubmitCommands()</summary>
+        [DllImport("RIQAudio")]
+        public static extern AudioCommandBuffer* RiqGetCommandBuffer();
+        /// <summary>Apply every queued command at once, call once per frame</summary>
+        [DllImport("RIQAudio")]
+        public static extern void RiqSubmitCommands();
+
+        /// <summary>Queue a command into the native command buffer, submits early if the buffer is full</summary>
+        public static void RiqQueueCommand(AudioCommandType type, uint handle, float value = 0.0f)
+        {
+            AudioCommandBuffer* commandBuffer = RiqGetCommandBuffer();
+            if (commandBuffer->Capacity == 0) return;
+
+            if (commandBuffer->Count >= commandBuffer->Capacity) RiqSubmitCommands();
+
+            AudioCommand* command = commandBuffer->Commands + commandBuffer->Count;
+            command->Type = type;
+            command->Handle = handle;
+            command->Value = value;
+
+            commandBuffer->Count++;
+        }
 
         [DllImport("RIQAudio")]
         private static extern Wave RiqLoadWave(sbyte* filePath);
@@ -51,6 +253,32 @@ namespace RIQAudioUnity
                 return wave;
             }
         }
+
+        [DllImport("RIQAudio")]
+        public static extern void RiqUnloadWave(Wave wave);
+
+        /// <summary>Generate wave peaks pyramid from wave data, used for waveform visualization</summary>
+        [DllImport("RIQAudio")]
+        public static extern WavePeaks RiqLoadWavePeaks(Wave wave);
+        /// <summary>Generate wave peaks pyramid from loaded sound data</summary>
+        [DllImport("RIQAudio")]
+        public static extern WavePeaks RiqLoadWavePeaksFromSound(Sound sound);
+        [DllImport("RIQAudio")]
+        public static extern void RiqUnloadWavePeaks(WavePeaks peaks);
+
+        [DllImport("RIQAudio")]
+        private static extern int RiqGetWavePeaks(WavePeaks peaks, uint startFrame, uint frameCount, WavePeak* binsOut, int binCount);
+        /// <summary>Get peaks for a frame range, binsOut holds one WavePeak per channel for every bin (i.e. one per pixel column)</summary>
+        public static int RiqGetWavePeaks(WavePeaks peaks, uint startFrame, uint frameCount, WavePeak[] binsOut)
+        {
+            // Empty or failed peaks have no channels, there is nothing to read
+            if (binsOut == null || peaks.Channels == 0) return 0;
+
+            fixed (WavePeak* binsOutNative = binsOut)
+            {
+                return RiqGetWavePeaks(peaks, startFrame, frameCount, binsOutNative, binsOut.Length / (int)peaks.Channels);
+            }
+        }
     }
 
     /// <summary>
@@ -85,6 +313,453 @@ namespace RIQAudioUnity
         public void* Data;
     }
 
+    /// <summary>
+    /// Audio backends, same order as miniaudio
+    /// </summary>
+    public enum AudioBackend : int
+    {
+        Default = -1,
+        Wasapi = 0,
+        DSound,
+        WinMM,
+        CoreAudio,
+        Sndio,
+        Audio4,
+        OSS,
+        PulseAudio,
+        Alsa,
+        Jack,
+        AAudio,
+        OpenSL,
+        WebAudio,
+        Custom,
+        Null
+    }
+
+    /// <summary>
+    /// Audio device init options, zero values let the backend decide
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct AudioDeviceOptions
+    {
+        /// <summary>
+        /// Requested sample rate, 0 for the device native rate
+        /// </summary>
+        public uint SampleRate;
+
+        /// <summary>
+        /// Requested period size in frames, 0 for the backend default
+        /// </summary>
+        public uint PeriodSizeInFrames;
+
+        /// <summary>
+        /// Requested number of periods, 0 for the backend default
+        /// </summary>
+        public uint Periods;
+
+        /// <summary>
+        /// Use the low latency performance profile (0 or 1)
+        /// </summary>
+        public int LowLatency;
+
+        /// <summary>
+        /// Preferred backend
+        /// </summary>
+        public AudioBackend Backend;
+
+        /// <summary>
+        /// Output channel layout
+        /// </summary>
+        public AudioChannelLayout Layout;
+    }
+
+    /// <summary>
+    /// Audio device values negotiated with the backend
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct AudioDeviceInfo
+    {
+        /// <summary>
+        /// Device sample rate used for mixing
+        /// </summary>
+        public uint SampleRate;
+
+        /// <summary>
+        /// Device output channels
+        /// </summary>
+        public uint Channels;
+
+        /// <summary>
+        /// Backend period size in frames (at InternalSampleRate)
+        /// </summary>
+        public uint PeriodSizeInFrames;
+
+        /// <summary>
+        /// Backend number of periods
+        /// </summary>
+        public uint Periods;
+
+        /// <summary>
+        /// Backend native sample rate
+        /// </summary>
+        public uint InternalSampleRate;
+
+        /// <summary>
+        /// Estimated output latency in frames (at SampleRate)
+        /// </summary>
+        public uint LatencyFrames;
+
+        /// <summary>
+        /// Estimated output latency in milliseconds
+        /// </summary>
+        public float LatencyMs;
+
+        /// <summary>
+        /// Backend in use
+        /// </summary>
+        public AudioBackend Backend;
+    }
+
+    /// <summary>
+    /// Mixing callback statistics, since init or the last reset
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct AudioMixerStats
+    {
+        /// <summary>
+        /// Mixing callbacks
+        /// </summary>
+        public ulong CallbackCount;
+
+        /// <summary>
+        /// Frames mixed
+        /// </summary>
+        public ulong FramesMixed;
+
+        /// <summary>
+        /// Buffers playing in the last callback
+        /// </summary>
+        public uint BuffersMixed;
+
+        /// <summary>
+        /// Most buffers playing in a single callback
+        /// </summary>
+        public uint MaxBuffersMixed;
+
+        /// <summary>
+        /// Callbacks that took longer than the audio they produced
+        /// </summary>
+        public uint Overruns;
+
+        /// <summary>
+        /// Last callback time, lock wait included
+        /// </summary>
+        public float LastCallbackMs;
+
+        /// <summary>
+        /// Average callback time
+        /// </summary>
+        public float AverageCallbackMs;
+
+        /// <summary>
+        /// Worst callback time
+        /// </summary>
+        public float WorstCallbackMs;
+
+        /// <summary>
+        /// Worst callback time over the duration of its frames, 1.0 is realtime
+        /// </summary>
+        public float WorstLoad;
+    }
+
+    /// <summary>
+    /// Latency calibration options
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct AudioCalibrationOptions
+    {
+        /// <summary>
+        /// Number of clicks emitted
+        /// </summary>
+        public int ClickCount;
+
+        /// <summary>
+        /// Average time between clicks
+        /// </summary>
+        public uint ClickIntervalMs;
+
+        /// <summary>
+        /// Longest round trip searched for
+        /// </summary>
+        public uint MaxLatencyMs;
+
+        /// <summary>
+        /// If > 0, the output delayed by this many frames is added to the captured signal (testing without a physical loop)
+        /// </summary>
+        public uint SyntheticLoopbackFrames;
+    }
+
+    /// <summary>
+    /// Latency calibration result, frames are at the device sample rate
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct AudioLatencyCalibration
+    {
+        /// <summary>
+        /// Click train found in the captured signal
+        /// </summary>
+        public int Success;
+
+        /// <summary>
+        /// Device sample rate during calibration
+        /// </summary>
+        public uint SampleRate;
+
+        /// <summary>
+        /// Measured time from emitting a click to capturing it
+        /// </summary>
+        public uint RoundTripFrames;
+
+        /// <summary>
+        /// Estimated capture side latency
+        /// </summary>
+        public uint InputLatencyFrames;
+
+        /// <summary>
+        /// Round trip minus input latency
+        /// </summary>
+        public uint OutputLatencyFrames;
+
+        /// <summary>
+        /// Round trip in milliseconds
+        /// </summary>
+        public float RoundTripMs;
+
+        /// <summary>
+        /// Output latency in milliseconds
+        /// </summary>
+        public float OutputLatencyMs;
+
+        /// <summary>
+        /// Normalized correlation of the match (0 to 1)
+        /// </summary>
+        public float Confidence;
+    }
+
+    /// <summary>
+    /// Meter levels snapshot, published once every metering window
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public unsafe struct AudioMeterLevels
+    {
+        /// <summary>
+        /// Snapshot number, 0 if nothing was metered yet or it could not be read consistently (poll again)
+        /// </summary>
+        public uint Sequence;
+
+        /// <summary>
+        /// Number of metered channels
+        /// </summary>
+        public uint Channels;
+
+        /// <summary>
+        /// Peak absolute level in the window, per channel
+        /// </summary>
+        public fixed float Peak[8];
+
+        /// <summary>
+        /// Root mean square level in the window, per channel
+        /// </summary>
+        public fixed float Rms[8];
+    }
+
+    /// <summary>
+    /// Biquad filter types, used by EQ stages
+    /// </summary>
+    public enum BiquadType : int
+    {
+        LowPass = 0,
+        HighPass,
+        BandPass,
+        Notch,
+        Peak,
+        LowShelf,
+        HighShelf
+    }
+
+    /// <summary>
+    /// Resampler used to play a sound at a different rate
+    /// </summary>
+    public enum AudioResamplerQuality : int
+    {
+        Converter = 0,
+        Linear,
+        Cubic
+    }
+
+    /// <summary>
+    /// Output channel layout, sounds are panned on the front left/right speakers and fed to center and surround ones on 5.1/7.1
+    /// </summary>
+    public enum AudioChannelLayout : int
+    {
+        Default = 0,
+        Mono = 1,
+        Stereo = 2,
+        Surround51 = 6,
+        Surround71 = 8
+    }
+
+    /// <summary>
+    /// Audio command types
+    /// </summary>
+    public enum AudioCommandType : uint
+    {
+        Play = 0,
+        Stop,
+        Pause,
+        Resume,
+        SetVolume,
+        SetPitch,
+        SetPan,
+        SetTempo,
+        SetResampler
+    }
+
+    /// <summary>
+    /// Audio command, queued by the game and applied on RiqSubmitCommands()
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct AudioCommand
+    {
+        /// <summary>
+        /// Command type
+        /// </summary>
+        public AudioCommandType Type;
+
+        /// <summary>
+        /// Target sound handle
+        /// </summary>
+        public uint Handle;
+
+        /// <summary>
+        /// Command parameter (volume, pitch, pan, tempo), unused by state commands
+        /// </summary>
+        public float Value;
+    }
+
+    /// <summary>
+    /// Audio command buffer, allocated natively
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public unsafe struct AudioCommandBuffer
+    {
+        /// <summary>
+        /// Commands array pointer
+        /// </summary>
+        public AudioCommand* Commands;
+
+        /// <summary>
+        /// Max number of commands
+        /// </summary>
+        public uint Capacity;
+
+        /// <summary>
+        /// Number of queued commands
+        /// </summary>
+        public uint Count;
+    }
+
+    /// <summary>
+    /// Sound bank, many sounds sharing one contiguous samples block
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public unsafe struct SoundBank
+    {
+        /// <summary>
+        /// Number of sounds
+        /// </summary>
+        public uint SoundCount;
+
+        /// <summary>
+        /// Sounds index pointer (SoundBankEntry)
+        /// </summary>
+        public IntPtr Entries;
+
+        /// <summary>
+        /// Sounds, owned by the bank
+        /// </summary>
+        public Sound* Sounds;
+
+        /// <summary>
+        /// Samples converted to device format
+        /// </summary>
+        public IntPtr SampleData;
+
+        /// <summary>
+        /// Bank file data
+        /// </summary>
+        public IntPtr FileData;
+    }
+
+    /// <summary>
+    /// Wave peak bin, one per channel
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct WavePeak
+    {
+        /// <summary>
+        /// Lowest sample value in the bin
+        /// </summary>
+        public float Min;
+
+        /// <summary>
+        /// Highest sample value in the bin
+        /// </summary>
+        public float Max;
+
+        /// <summary>
+        /// Root mean square of the bin
+        /// </summary>
+        public float Rms;
+    }
+
+    /// <summary>
+    /// Wave peaks pyramid, used for waveform visualization
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public unsafe struct WavePeaks
+    {
+        /// <summary>
+        /// Total number of frames covered by the pyramid
+        /// </summary>
+        public uint FrameCount;
+
+        /// <summary>
+        /// Frequency of the source data (samples per second)
+        /// </summary>
+        public uint SampleRate;
+
+        /// <summary>
+        /// Number of channels of the source data
+        /// </summary>
+        public uint Channels;
+
+        /// <summary>
+        /// Level 0 bin size in frames, as a power of two
+        /// </summary>
+        public uint BaseBinShift;
+
+        /// <summary>
+        /// Number of levels in the pyramid
+        /// </summary>
+        public uint LevelCount;
+
+        /// <summary>
+        /// Peaks data pointer
+        /// </summary>
+        public void* Data;
+    }
+
     /// <summary>
     /// Sound effects
     /// </summary>
@@ -4,9 +4,22 @@ workspace "RIQAudio"
     configurations
     {
         "Debug",
-        "Release"
+        "Release",
+        "ReleaseNoSIMD",
+        "TSan"
     }
 
+    -- ThreadSanitizer build of every project, gcc/clang only, RIQAudioStress is meant to run in it
+    filter { "configurations:TSan", "toolset:not msc*" }
+        buildoptions { "-fsanitize=thread" }
+        linkoptions { "-fsanitize=thread" }
+
+    filter "configurations:TSan"
+        symbols "On"
+        optimize "Debug"
+
+    filter {}
+
 outputdir = "%{cfg.buildcfg}-%{cfg.system}-%{cfg.architecture}"
 
 project "RIQAudio"
@@ -44,4 +57,111 @@ project "RIQAudio"
         symbols "On"
 
     filter "configurations:Release"
-        optimize "On"
\ No newline at end of file
+        optimize "On"
+
+    -- Scalar mixer, golden renders must match it bit for bit
+    filter "configurations:ReleaseNoSIMD"
+        defines "RIQ_NO_SIMD"
+        optimize "On"
+
+-- Golden render tests, run from the project folder: RIQAudioTests [--update] [goldenDir]
+project "RIQAudioTests"
+    location "RIQAudioTests"
+    kind "ConsoleApp"
+    language "C++"
+    cppdialect "C++17"
+
+    staticruntime "On"
+
+    targetdir ("bin/" .. outputdir .. "/%{prj.name}")
+    objdir ("bin-int/" .. outputdir .. "/%{prj.name}")
+    debugdir "%{prj.name}"
+
+    files
+    {
+        "%{prj.name}/src/**.hpp",
+        "%{prj.name}/src/**.cpp",
+    }
+
+    includedirs
+    {
+        "RIQAudio/src",
+        "RIQAudio/vendor"
+    }
+
+    links
+    {
+        "RIQAudio"
+    }
+
+    defines
+    {
+        "_CRT_SECURE_NO_WARNINGS"
+    }
+
+    -- The library is built into the Unity plugin folder, the test needs it next to the executable
+    filter "system:windows"
+        postbuildcommands
+        {
+            "{COPYFILE} \"%{wks.location}/RIQAudioUnity/Assets/RIQAudioSharp/bin/RIQAudio.dll\" \"%{cfg.targetdir}\""
+        }
+
+    filter "configurations:Debug"
+        symbols "On"
+
+    filter "configurations:Release"
+        optimize "On"
+
+    filter "configurations:ReleaseNoSIMD"
+        defines "RIQ_NO_SIMD"
+        optimize "On"
+-- Stress and soak harness, run from the project folder: RIQAudioStress [--players N] [--loaders N] [--seconds S] [--unpaced] [--scale]
+project "RIQAudioStress"
+    location "RIQAudioTests"
+    kind "ConsoleApp"
+    language "C++"
+    cppdialect "C++17"
+
+    staticruntime "On"
+
+    targetdir ("bin/" .. outputdir .. "/%{prj.name}")
+    objdir ("bin-int/" .. outputdir .. "/%{prj.name}")
+    debugdir "RIQAudioTests"
+
+    files
+    {
+        "RIQAudioTests/stress/**.cpp",
+    }
+
+    includedirs
+    {
+        "RIQAudio/src",
+        "RIQAudio/vendor",
+        "RIQAudioTests/src"
+    }
+
+    links
+    {
+        "RIQAudio"
+    }
+
+    defines
+    {
+        "_CRT_SECURE_NO_WARNINGS"
+    }
+
+    filter "system:windows"
+        postbuildcommands
+        {
+            "{COPYFILE} \"%{wks.location}/RIQAudioUnity/Assets/RIQAudioSharp/bin/RIQAudio.dll\" \"%{cfg.targetdir}\""
+        }
+
+    filter "configurations:Debug"
+        symbols "On"
+
+    filter "configurations:Release"
+        optimize "On"
+
+    filter "configurations:ReleaseNoSIMD"
+        defines "RIQ_NO_SIMD"
+        optimize "On"